@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Samsung Galaxy Book series extras driver tracepoints
+ *
+ * Copyright (c) 2024 Joshua Grisham <josh@joshuagrisham.com>
+ * Copyright (c) 2024 Giulio Girardi <giulio.girardi@protechgroup.it>
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM samsung_galaxybook
+
+#if !defined(_SAMSUNG_GALAXYBOOK_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _SAMSUNG_GALAXYBOOK_TRACE_H
+
+#include <linux/tracepoint.h>
+
+/* method names are always 4 characters (CSFI, CSXI, etc) */
+#define GALAXYBOOK_TRACE_METHOD_LEN 5
+
+/* offset of iob0 within a SAWB buffer (after safn, sasb, rflg, caid, fncn and subn) */
+#define GALAXYBOOK_TRACE_IOB0_OFFSET 23
+
+#define GALAXYBOOK_HOTKEY_SOURCE_I8042 0
+#define GALAXYBOOK_HOTKEY_SOURCE_ACPI  1
+
+TRACE_EVENT(galaxybook_sawb_request,
+
+	TP_PROTO(const char *method, u16 safn, u16 sasb, u8 gunm, u8 fncn, u8 subn),
+
+	TP_ARGS(method, safn, sasb, gunm, fncn, subn),
+
+	TP_STRUCT__entry(
+		__array(char, method, GALAXYBOOK_TRACE_METHOD_LEN)
+		__field(u16, safn)
+		__field(u16, sasb)
+		__field(u8, gunm)
+		__field(u8, fncn)
+		__field(u8, subn)
+	),
+
+	TP_fast_assign(
+		strscpy(__entry->method, method, GALAXYBOOK_TRACE_METHOD_LEN);
+		__entry->safn = safn;
+		__entry->sasb = sasb;
+		__entry->gunm = gunm;
+		__entry->fncn = fncn;
+		__entry->subn = subn;
+	),
+
+	TP_printk("method=%s safn=0x%04x sasb=0x%02x gunm=0x%02x fncn=0x%02x subn=0x%02x",
+		__entry->method, __entry->safn, __entry->sasb, __entry->gunm,
+		__entry->fncn, __entry->subn)
+);
+
+TRACE_EVENT(galaxybook_sawb_response,
+
+	TP_PROTO(const char *method, u16 sasb, const u8 *data, u32 length, int status,
+		 u64 latency_ns),
+
+	TP_ARGS(method, sasb, data, length, status, latency_ns),
+
+	TP_STRUCT__entry(
+		__array(char, method, GALAXYBOOK_TRACE_METHOD_LEN)
+		__field(u16, sasb)
+		__field(u32, length)
+		__field(u8, rflg)
+		__field(u8, gunm)
+		__field(u8, guds0)
+		__field(u8, iob0)
+		__field(int, status)
+		__field(u64, latency_ns)
+	),
+
+	TP_fast_assign(
+		strscpy(__entry->method, method, GALAXYBOOK_TRACE_METHOD_LEN);
+		__entry->sasb = sasb;
+		__entry->length = data ? length : 0;
+		__entry->rflg = data && length > 4 ? data[4] : 0;
+		__entry->gunm = data && length > 5 ? data[5] : 0;
+		__entry->guds0 = data && length > 6 ? data[6] : 0;
+		__entry->iob0 = data && length > GALAXYBOOK_TRACE_IOB0_OFFSET ?
+				data[GALAXYBOOK_TRACE_IOB0_OFFSET] : 0;
+		__entry->status = status;
+		__entry->latency_ns = latency_ns;
+	),
+
+	TP_printk("method=%s sasb=0x%02x length=%u rflg=0x%02x gunm=0x%02x guds0=0x%02x iob0=0x%02x status=%d latency_ns=%llu",
+		__entry->method, __entry->sasb, __entry->length, __entry->rflg,
+		__entry->gunm, __entry->guds0, __entry->iob0, __entry->status,
+		__entry->latency_ns)
+);
+
+TRACE_EVENT(galaxybook_hotkey,
+
+	TP_PROTO(u8 source, u32 code),
+
+	TP_ARGS(source, code),
+
+	TP_STRUCT__entry(
+		__field(u8, source)
+		__field(u32, code)
+	),
+
+	TP_fast_assign(
+		__entry->source = source;
+		__entry->code = code;
+	),
+
+	TP_printk("source=%s code=0x%02x",
+		__print_symbolic(__entry->source,
+			{ GALAXYBOOK_HOTKEY_SOURCE_I8042, "i8042" },
+			{ GALAXYBOOK_HOTKEY_SOURCE_ACPI,  "acpi" }),
+		__entry->code)
+);
+
+TRACE_EVENT(galaxybook_fan_read,
+
+	TP_PROTO(int channel, int level, unsigned int rpm, int status, u64 latency_ns),
+
+	TP_ARGS(channel, level, rpm, status, latency_ns),
+
+	TP_STRUCT__entry(
+		__field(int, channel)
+		__field(int, level)
+		__field(unsigned int, rpm)
+		__field(int, status)
+		__field(u64, latency_ns)
+	),
+
+	TP_fast_assign(
+		__entry->channel = channel;
+		__entry->level = level;
+		__entry->rpm = rpm;
+		__entry->status = status;
+		__entry->latency_ns = latency_ns;
+	),
+
+	TP_printk("channel=%d level=%d rpm=%u status=%d latency_ns=%llu",
+		__entry->channel, __entry->level, __entry->rpm, __entry->status,
+		__entry->latency_ns)
+);
+
+TRACE_EVENT(galaxybook_profile_change,
+
+	TP_PROTO(int profile, u8 performance_mode),
+
+	TP_ARGS(profile, performance_mode),
+
+	TP_STRUCT__entry(
+		__field(int, profile)
+		__field(u8, performance_mode)
+	),
+
+	TP_fast_assign(
+		__entry->profile = profile;
+		__entry->performance_mode = performance_mode;
+	),
+
+	TP_printk("profile=%d performance_mode=0x%02x",
+		__entry->profile, __entry->performance_mode)
+);
+
+#endif /* _SAMSUNG_GALAXYBOOK_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE samsung-galaxybook-trace
+
+#include <trace/define_trace.h>
@@ -18,11 +18,22 @@
 #include <linux/acpi.h>
 #include <linux/dmi.h>
 #include <linux/hwmon.h>
+#include <linux/hwmon-sysfs.h>
 #include <linux/leds.h>
 #include <linux/platform_device.h>
 #include <linux/platform_profile.h>
 #include <linux/i8042.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/log2.h>
+#include <linux/jump_label.h>
+#include <linux/seq_file.h>
+#include <linux/debugfs.h>
 #include <linux/workqueue.h>
+#include <linux/kfifo.h>
+#include <linux/spinlock.h>
+#include <linux/units.h>
 #include <linux/input.h>
 #include <linux/input/sparse-keymap.h>
 #include <linux/nls.h>
@@ -30,6 +41,9 @@
 
 #include <acpi/battery.h>
 
+#define CREATE_TRACE_POINTS
+#include "samsung-galaxybook-trace.h"
+
 #define SAMSUNG_GALAXYBOOK_CLASS  "samsung-galaxybook"
 #define SAMSUNG_GALAXYBOOK_NAME   "Samsung Galaxy Book Extras"
 
@@ -59,8 +73,22 @@ static bool acpi_hotkeys_was_set;
 static bool wmi_hotkeys = true;
 static bool wmi_hotkeys_was_set;
 
+static unsigned int fan_sample_period_ms;
+
 static bool debug = false;
 
+/* debug is checked in hot paths (including the i8042 filter) so it is backed by a static key */
+static DEFINE_STATIC_KEY_FALSE(debug_key);
+#define debug_enabled() static_branch_unlikely(&debug_key)
+
+static void debug_key_update(void)
+{
+	if (debug)
+		static_branch_enable(&debug_key);
+	else
+		static_branch_disable(&debug_key);
+}
+
 static void warn_param_override(const char *param_name)
 {
 	pr_warn("parameter '%s' has been overridden; if your device needs this in " \
@@ -105,7 +133,26 @@ module_param_cb(acpi_hotkeys, &galaxybook_module_param_ops, &acpi_hotkeys, 0644)
 MODULE_PARM_DESC(acpi_hotkeys, "Enable ACPI hotkey events (default on)");
 module_param_cb(wmi_hotkeys, &galaxybook_module_param_ops, &wmi_hotkeys, 0644);
 MODULE_PARM_DESC(wmi_hotkeys, "Enable WMI hotkey events (default on)");
-module_param(debug, bool, 0644);
+static int galaxybook_debug_param_set(const char *val, const struct kernel_param *kp)
+{
+	int err;
+
+	err = param_set_bool(val, kp);
+	if (err)
+		return err;
+
+	debug_key_update();
+	return 0;
+}
+static const struct kernel_param_ops galaxybook_debug_param_ops = {
+	.set = galaxybook_debug_param_set,
+	.get = param_get_bool,
+};
+
+module_param(fan_sample_period_ms, uint, 0644);
+MODULE_PARM_DESC(fan_sample_period_ms,
+		"Period in ms of background fan sampling into debugfs fan*_samples (default 0 = off)");
+module_param_cb(debug, &galaxybook_debug_param_ops, &debug, 0644);
 MODULE_PARM_DESC(debug, "Enable debug messages (default off)");
 
 
@@ -113,6 +160,23 @@ MODULE_PARM_DESC(debug, "Enable debug messages (default off)");
  * Device definitions, matching, and quirks
  */
 
+/* actions for extended (0xe0-prefixed) scancodes captured by the i8042 filter */
+enum galaxybook_i8042_action {
+	GB_I8042_NONE = 0,
+	GB_I8042_KBD_BACKLIGHT_KEYDOWN,
+	GB_I8042_KBD_BACKLIGHT_KEYUP,
+	GB_I8042_ALLOW_RECORDING_KEYDOWN,
+	GB_I8042_ALLOW_RECORDING_KEYUP,
+	GB_I8042_ACTION_COUNT,
+};
+
+static const u8 galaxybook_i8042_keymap[256] = {
+	[0x2c] = GB_I8042_KBD_BACKLIGHT_KEYDOWN,
+	[0xac] = GB_I8042_KBD_BACKLIGHT_KEYUP,
+	[0x1f] = GB_I8042_ALLOW_RECORDING_KEYDOWN,
+	[0x9f] = GB_I8042_ALLOW_RECORDING_KEYUP,
+};
+
 struct galaxybook_device_quirks {
 	bool disable_kbd_backlight;
 	bool disable_battery_threshold;
@@ -121,8 +185,12 @@ struct galaxybook_device_quirks {
 	bool disable_i8042_filter;
 	bool disable_acpi_hotkeys;
 	bool disable_wmi_hotkeys;
+	/* replaces galaxybook_i8042_keymap for models with different extended scancodes */
+	const u8 *i8042_keymap;
 };
 
+static const u8 *i8042_keymap = galaxybook_i8042_keymap;
+
 static const struct galaxybook_device_quirks sam0427_quirks = {
 	.disable_performance_mode = true,
 	.disable_fan_speed = true,
@@ -148,45 +216,304 @@ static const struct dmi_system_id galaxybook_dmi_ids[] = {
 	{}
 };
 
+/* location of a named field within the EC address space, as laid out by a Field in the DSDT */
+struct galaxybook_ec_field {
+	const char *name;
+	u8 offset;
+	u8 shift;
+	u8 mask;
+};
+
+/* H_EC.ECR layout which is the same in all of the DSDTs in dsdt/ */
+static const struct galaxybook_ec_field galaxybook_ec_fields[] = {
+	{ "FANS", 0x87, 0, 0x0f },
+	{ "CTMP", 0xc0, 0, 0xff },
+	{ },
+};
+
+#define GALAXYBOOK_EC_DMI(product, fields) {					\
+		.ident = product,						\
+		.matches = {							\
+			DMI_MATCH(DMI_SYS_VENDOR, "SAMSUNG ELECTRONICS CO., LTD."),	\
+			DMI_MATCH(DMI_PRODUCT_NAME, product),			\
+		},								\
+		.driver_data = (void *)fields,					\
+	}
+
+/* models where EC fields can be read directly from the EC, once the layout is verified at probe */
+static const struct dmi_system_id galaxybook_ec_dmi_ids[] = {
+	GALAXYBOOK_EC_DMI("950QDB", galaxybook_ec_fields),
+	GALAXYBOOK_EC_DMI("950XDB", galaxybook_ec_fields),
+	GALAXYBOOK_EC_DMI("950XED", galaxybook_ec_fields),
+	GALAXYBOOK_EC_DMI("960XFH", galaxybook_ec_fields),
+	{}
+};
+
+#define ACPI_METHOD_ENABLE           "SDLS"
+#define ACPI_METHOD_SETTINGS         "CSFI"
+#define ACPI_METHOD_PERFORMANCE_MODE "CSXI"
+
+enum galaxybook_method {
+	GB_METHOD_ENABLE,
+	GB_METHOD_SETTINGS,
+	GB_METHOD_PERFORMANCE_MODE,
+	GB_METHOD_COUNT,
+};
+
+static const char * const galaxybook_method_names[] = {
+	[GB_METHOD_ENABLE] = ACPI_METHOD_ENABLE,
+	[GB_METHOD_SETTINGS] = ACPI_METHOD_SETTINGS,
+	[GB_METHOD_PERFORMANCE_MODE] = ACPI_METHOD_PERFORMANCE_MODE,
+};
+static_assert(ARRAY_SIZE(galaxybook_method_names) == GB_METHOD_COUNT);
+
+#define SAWB_LEN_SETTINGS 0x15
+#define SAWB_LEN_PERFORMANCE_MODE 0x100
+
+/* output buffer must fit the acpi_object header plus the largest response buffer */
+#define SAWB_RESPONSE_SIZE (sizeof(union acpi_object) + \
+		ALIGN(SAWB_LEN_PERFORMANCE_MODE, sizeof(u64)))
+
+struct galaxybook_lock_stats {
+	u64 acquisitions;
+	u64 contended;
+	u64 wait_total_ns;
+	u64 wait_max_ns;
+	u64 hold_total_ns;
+	u64 hold_max_ns;
+};
+
+/* SAWB operations which are tracked separately in the latency histograms */
+enum galaxybook_op {
+	GB_OP_ENABLE_FEATURE,
+	GB_OP_KBD_BACKLIGHT,
+	GB_OP_START_ON_LID_OPEN,
+	GB_OP_BATTERY_THRESHOLD,
+	GB_OP_USB_CHARGE,
+	GB_OP_ALLOW_RECORDING,
+	GB_OP_NOTIFICATIONS,
+	GB_OP_SETTINGS_OTHER,
+	GB_OP_PERFORMANCE_MODE_LIST,
+	GB_OP_PERFORMANCE_MODE_GET,
+	GB_OP_PERFORMANCE_MODE_SET,
+	GB_OP_PERFORMANCE_MODE_OTHER,
+	GB_OP_COUNT,
+};
+
+/* bucket 0 is below 1 us, bucket n is [2^(n-1), 2^n) us, and the last bucket has the rest */
+#define GB_LATENCY_BUCKETS 20
+
+struct galaxybook_latency_hist {
+	u64 count;
+	u64 errors;
+	u64 min_ns;
+	u64 max_ns;
+	u64 total_ns;
+	u64 buckets[GB_LATENCY_BUCKETS];
+};
+
+/* record format of the debugfs fan*_samples files */
+struct galaxybook_fan_sample {
+	u64 timestamp_ns;
+	s32 level;
+	u32 rpm;
+};
+
+#define FAN_SAMPLES_COUNT 256
+
+#define FAN_LEVELS_MAX 16
+/* time in states which did not fit in the table is counted here instead of being dropped */
+#define FAN_STATS_OTHER FAN_LEVELS_MAX
+/* _FST speeds follow the tachometer on some models, so they are grouped into states this wide */
+#define FAN_STATS_RPM_BUCKET 500
+
+/* an EC field holding a fan level or temperature, shared by everything which reads it */
+struct galaxybook_field {
+	const char *name;
+	acpi_handle handle;
+	/* set when the field can be read with ec_read() instead of through the AML interpreter */
+	const struct galaxybook_ec_field *ec;
+
+	/* last value read, reused by other fans sharing this field */
+	struct mutex lock;
+	bool valid;
+	u64 read_at;
+	unsigned long long value;
+};
+
 struct galaxybook_fan {
-	struct acpi_device fan;
+	struct acpi_device *adev;
 	char *description;
 	bool supports_fst;
+	acpi_handle fst;
+	struct galaxybook_field *field;
+	bool notify_installed;
 	unsigned int *fan_speeds;
 	int fan_speeds_count;
 	struct dev_ext_attribute fan_speed_rpm_ext_attr;
+
+	/* last successful speed reading, shared by all readers within fan_update_interval_ms */
+	struct mutex sample_lock;
+	bool sample_valid;
+	u64 sampled_at;
+	unsigned int sample_speed;
+	int sample_level;
+
+	/* ring buffer filled by the background fan sampler, oldest entry first once full */
+	spinlock_t samples_lock;
+	struct galaxybook_fan_sample *samples;
+	unsigned int samples_next;
+	unsigned int samples_count;
+	struct dentry *samples_file;
+
+	/*
+	 * time spent in each state (the level, or the speed rounded down to FAN_STATS_RPM_BUCKET for
+	 * fans using _FST) as seen by the samples taken by the driver, protected by sample_lock
+	 */
+	unsigned int stats_keys[FAN_LEVELS_MAX];
+	u64 stats_time_ns[FAN_LEVELS_MAX + 1];
+	int stats_count;
+	int stats_state;
+	unsigned int stats_key;
+	u64 stats_since;
+	u64 stats_transitions;
+	struct dentry *stats_file;
+};
+
+/* a temperature channel, for one or more thermal zones reading the same EC field */
+struct galaxybook_temp {
+	struct galaxybook_field *field;
+	bool has_crit;
+	long crit;	/* millidegrees Celsius, from _CRT */
+};
+
+/* laptops have at most BAT0 and BAT1 */
+#define MAX_BATTERY_COUNT 2
+
+/* chip, fan, temp and the terminating NULL */
+#define GB_HWMON_INFO_COUNT 4
+
+/* extra hwmon attributes of each fan, whose names depend on the fan index */
+enum galaxybook_fan_attr_item {
+	GB_HWMON_FAN_ATTR_LEVELS,	/* fan*_levels */
+	GB_HWMON_FAN_ATTR_LEVEL,	/* fan*_level */
+	GB_HWMON_FAN_ATTR_COUNT,
+};
+
+struct galaxybook_fan_attr {
+	struct sensor_device_attribute sda;
+	char name[16];
+};
+
+enum galaxybook_cache_item {
+	GB_CACHE_KBD_BACKLIGHT,
+	GB_CACHE_START_ON_LID_OPEN,
+	GB_CACHE_USB_CHARGE,
+	GB_CACHE_ALLOW_RECORDING,
+	GB_CACHE_CHARGE_CONTROL_END_THRESHOLD,
+	GB_CACHE_PERFORMANCE_MODE,
+	GB_CACHE_COUNT,
 };
 
-#define MAX_FAN_COUNT 5
+#define GB_CACHE_ALL (BIT(GB_CACHE_KBD_BACKLIGHT) | \
+		BIT(GB_CACHE_START_ON_LID_OPEN) | \
+		BIT(GB_CACHE_USB_CHARGE) | \
+		BIT(GB_CACHE_ALLOW_RECORDING) | \
+		BIT(GB_CACHE_CHARGE_CONTROL_END_THRESHOLD) | \
+		BIT(GB_CACHE_PERFORMANCE_MODE))
 
 struct samsung_galaxybook {
 	struct platform_device *platform;
 	struct acpi_device *acpi;
+	acpi_handle methods[GB_METHOD_COUNT];
+
+	/* preallocated output buffer for all SAWB transactions, protected by sawb_lock */
+	struct mutex sawb_lock;
+	struct galaxybook_lock_stats sawb_lock_stats;
+	u64 sawb_locked_at;
+	struct galaxybook_latency_hist sawb_latency[GB_OP_COUNT];
+	union {
+		union acpi_object obj;
+		u8 bytes[SAWB_RESPONSE_SIZE];
+	} sawb_response;
 
 	struct led_classdev kbd_backlight;
-	struct work_struct kbd_backlight_hotkey_work;
 
+	/* reported to from hotkey work, sysfs and ACPI notify, so only used under input_lock */
+	struct mutex input_lock;
 	struct input_dev *input;
 	struct key_entry *keymap;
 
 	u8 *profile_performance_modes;
+	u8 performance_mode;
 	struct platform_profile_handler profile_handler;
-	struct work_struct performance_mode_hotkey_work;
 
-	struct work_struct allow_recording_hotkey_work;
-
-	struct galaxybook_fan fans[MAX_FAN_COUNT];
+	/* hotkey events from the i8042 filter and ACPI notify handler, drained by hotkey_work */
+	DECLARE_KFIFO(hotkey_fifo, u8, 32);
+	spinlock_t hotkey_fifo_lock;
+	struct workqueue_struct *hotkey_wq;
+	struct work_struct hotkey_work;
+	/* kbd_backlight hotkey presses not yet applied; only used from hotkey_wq */
+	unsigned int kbd_backlight_hotkey_presses;
+	struct delayed_work kbd_backlight_hotkey_work;
+
+	/* batteries added through galaxybook_battery_hook, notified on battery state changes */
+	struct mutex batteries_lock;
+	struct power_supply *batteries[MAX_BATTERY_COUNT];
+
+	/* sized from the number of fan devices in ACPI; only the first fans_count are in use */
+	struct galaxybook_fan *fans;
+	int fans_allocated;
 	int fans_count;
+	struct galaxybook_temp *temps;
+	int temps_count;
+	/* EC fields read by fans and temperature channels, at most one per fan or channel */
+	struct galaxybook_field *fields;
+	int fields_allocated;
+	int fields_count;
+	unsigned int fan_update_interval_ms;
+	/* fan sampler keeps running until no reader has shown up for FAN_SAMPLER_IDLE_MS */
+	struct delayed_work fan_sampler_work;
+	unsigned long fan_sampler_active_at;
+
+	/*
+	 * shadow copies of firmware settings, valid when their bit is set in cache_valid; each
+	 * setting's lock is held from checking the bit until the value read or written is stored
+	 */
+	unsigned long cache_valid;
+	struct mutex cache_locks[GB_CACHE_COUNT];
+	/* not kbd_backlight.brightness, which the LED core sets before asking the firmware */
+	enum led_brightness kbd_backlight_brightness;
+	bool start_on_lid_open;
+	bool usb_charge;
+	bool allow_recording;
+	u8 charge_control_end_threshold;
 
 #if IS_ENABLED(CONFIG_HWMON)
 	struct device *hwmon;
+	/* channel info is built at runtime since the number of fans is only known after probe */
+	struct hwmon_chip_info hwmon_chip_info;
+	const struct hwmon_channel_info *hwmon_info[GB_HWMON_INFO_COUNT];
+	struct hwmon_channel_info hwmon_fan_info;
+	u32 *hwmon_fan_config;
+	struct hwmon_channel_info hwmon_temp_info;
+	u32 *hwmon_temp_config;
+	/* GB_HWMON_FAN_ATTR_COUNT per fan, see galaxybook_fan_attr_get */
+	struct galaxybook_fan_attr *hwmon_fan_attrs;
+	struct attribute **hwmon_fan_attr_ptrs;
+	struct attribute_group hwmon_fan_group;
+	const struct attribute_group *hwmon_groups[2];
 #endif
+
+	struct dentry *debugfs;
 };
 static struct samsung_galaxybook *galaxybook_ptr;
 
-#define ACPI_METHOD_ENABLE           "SDLS"
-#define ACPI_METHOD_SETTINGS         "CSFI"
-#define ACPI_METHOD_PERFORMANCE_MODE "CSXI"
+enum galaxybook_hotkey_event {
+	GB_HOTKEY_KBD_BACKLIGHT,
+	GB_HOTKEY_ALLOW_RECORDING,
+	GB_HOTKEY_PERFORMANCE_MODE,
+};
 
 /* guid 8246028d-8bca-4a55-ba0f-6f1e6b921b8f */
 static const guid_t performance_mode_guid_value =
@@ -207,9 +534,6 @@ static const guid_t performance_mode_guid_value =
 #define GUNM_SET 0x82
 #define GUNM_GET 0x81
 
-#define SAWB_LEN_SETTINGS 0x15
-#define SAWB_LEN_PERFORMANCE_MODE 0x100
-
 struct sawb {
 	u16 safn;
 	u16 sasb;
@@ -241,12 +565,28 @@ struct sawb {
 	};
 };
 
+/* which part of the response should be copied back into the request buffer */
+#define SAWB_RET_NONE    0, 0
+#define SAWB_RET(field)  offsetof(struct sawb, field), sizeof_field(struct sawb, field)
+
 #define ACPI_FAN_DEVICE_ID    "PNP0C0B"
 #define ACPI_FAN_SPEED_LIST   "FANT"
-#define ACPI_FAN_SPEED_VALUE  "\\_SB.PC00.LPCB.H_EC.FANS"
+#define ACPI_FAN_SPEED_VALUE  "FANS"
+#define ACPI_EC_DEVICE_ID     "PNP0C09"
+
+#define FAN_UPDATE_INTERVAL_DEFAULT_MS  1000
+#define FAN_UPDATE_INTERVAL_MAX_MS      60000
+
+#define FAN_SAMPLER_IDLE_MS  30000
+
+/* sent to the fan device by the EC query for fan level changes (e.g. _Q76) */
+#define ACPI_FAN_NOTIFY_STATUS_CHANGED  0x80
 
 #define KBD_BACKLIGHT_MAX_BRIGHTNESS  3
 
+/* presses of the kbd_backlight hotkey within this window are applied as one change */
+#define KBD_BACKLIGHT_HOTKEY_SETTLE_MS  100
+
 #define ACPI_NOTIFY_BATTERY_STATE_CHANGED    0x61
 #define ACPI_NOTIFY_DEVICE_ON_TABLE          0x6c
 #define ACPI_NOTIFY_DEVICE_OFF_TABLE         0x6d
@@ -255,8 +595,8 @@ struct sawb {
 static const struct key_entry galaxybook_acpi_keymap[] = {
 	{KE_KEY, ACPI_NOTIFY_BATTERY_STATE_CHANGED, { KEY_BATTERY } },
 	{KE_KEY, ACPI_NOTIFY_HOTKEY_PERFORMANCE_MODE, { KEY_PROG3 } },
-	{KE_KEY, ACPI_NOTIFY_DEVICE_ON_TABLE, { KEY_F14 } },
-	{KE_KEY, ACPI_NOTIFY_DEVICE_OFF_TABLE, { KEY_F15 } },
+	{KE_SW, ACPI_NOTIFY_DEVICE_ON_TABLE, { .sw = { SW_TABLET_MODE, 1 } } },
+	{KE_SW, ACPI_NOTIFY_DEVICE_OFF_TABLE, { .sw = { SW_TABLET_MODE, 0 } } },
 	{KE_END, 0},
 };
 
@@ -274,7 +614,7 @@ static void pr_warn_create_issue(void)
 static void debug_print_acpi_object_buffer(const char *level, const char *header_str,
 				const union acpi_object *obj)
 {
-	if (debug) {
+	if (debug_enabled()) {
 		printk("%ssamsung_galaxybook: [DEBUG] %s\n", level, header_str);
 		print_hex_dump(level, "samsung_galaxybook: [DEBUG]     ", DUMP_PREFIX_NONE, 16, 1,
 				obj->buffer.pointer, obj->buffer.length, false);
@@ -303,13 +643,232 @@ static char * get_acpi_device_description(struct acpi_device *acpi_dev)
 	return NULL;
 }
 
-static int galaxybook_acpi_method(struct samsung_galaxybook *galaxybook, acpi_string method,
-				struct sawb *buf, u32 len, const char *purpose_str, struct sawb *ret)
+/*
+ * All SAWB transactions are serialized by sawb_lock so that the firmware does not have to do it
+ * (with unbounded waits on its own mutex); the time spent waiting for and holding the lock is
+ * recorded so that contention can be seen in debugfs.
+ */
+static void galaxybook_sawb_lock(struct samsung_galaxybook *galaxybook)
+{
+	struct galaxybook_lock_stats *stats = &galaxybook->sawb_lock_stats;
+	u64 start = ktime_get_ns();
+	bool contended = false;
+	u64 wait;
+
+	if (!mutex_trylock(&galaxybook->sawb_lock)) {
+		contended = true;
+		mutex_lock(&galaxybook->sawb_lock);
+	}
+
+	galaxybook->sawb_locked_at = ktime_get_ns();
+	wait = galaxybook->sawb_locked_at - start;
+
+	stats->acquisitions++;
+	if (contended)
+		stats->contended++;
+	stats->wait_total_ns += wait;
+	if (wait > stats->wait_max_ns)
+		stats->wait_max_ns = wait;
+}
+
+static void galaxybook_sawb_unlock(struct samsung_galaxybook *galaxybook)
+{
+	struct galaxybook_lock_stats *stats = &galaxybook->sawb_lock_stats;
+	u64 hold = ktime_get_ns() - galaxybook->sawb_locked_at;
+
+	stats->hold_total_ns += hold;
+	if (hold > stats->hold_max_ns)
+		stats->hold_max_ns = hold;
+
+	mutex_unlock(&galaxybook->sawb_lock);
+}
+
+static int sawb_lock_stats_show(struct seq_file *m, void *v)
+{
+	struct samsung_galaxybook *galaxybook = m->private;
+	struct galaxybook_lock_stats stats;
+
+	mutex_lock(&galaxybook->sawb_lock);
+	stats = galaxybook->sawb_lock_stats;
+	mutex_unlock(&galaxybook->sawb_lock);
+
+	seq_printf(m, "acquisitions: %llu\n", stats.acquisitions);
+	seq_printf(m, "contended:    %llu\n", stats.contended);
+	seq_printf(m, "wait_max_ns:  %llu\n", stats.wait_max_ns);
+	seq_printf(m, "wait_avg_ns:  %llu\n", stats.acquisitions ?
+			div64_u64(stats.wait_total_ns, stats.acquisitions) : 0);
+	seq_printf(m, "hold_max_ns:  %llu\n", stats.hold_max_ns);
+	seq_printf(m, "hold_avg_ns:  %llu\n", stats.acquisitions ?
+			div64_u64(stats.hold_total_ns, stats.acquisitions) : 0);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(sawb_lock_stats);
+
+static const char * const galaxybook_op_names[] = {
+	[GB_OP_ENABLE_FEATURE] = ACPI_METHOD_SETTINGS " enable_feature",
+	[GB_OP_KBD_BACKLIGHT] = ACPI_METHOD_SETTINGS " kbd_backlight",
+	[GB_OP_START_ON_LID_OPEN] = ACPI_METHOD_SETTINGS " power_management_a3",
+	[GB_OP_BATTERY_THRESHOLD] = ACPI_METHOD_SETTINGS " power_management_e9",
+	[GB_OP_USB_CHARGE] = ACPI_METHOD_SETTINGS " usb_charge",
+	[GB_OP_ALLOW_RECORDING] = ACPI_METHOD_SETTINGS " allow_recording",
+	[GB_OP_NOTIFICATIONS] = ACPI_METHOD_SETTINGS " notifications",
+	[GB_OP_SETTINGS_OTHER] = ACPI_METHOD_SETTINGS " other",
+	[GB_OP_PERFORMANCE_MODE_LIST] = ACPI_METHOD_PERFORMANCE_MODE " performance_mode_list",
+	[GB_OP_PERFORMANCE_MODE_GET] = ACPI_METHOD_PERFORMANCE_MODE " performance_mode_get",
+	[GB_OP_PERFORMANCE_MODE_SET] = ACPI_METHOD_PERFORMANCE_MODE " performance_mode_set",
+	[GB_OP_PERFORMANCE_MODE_OTHER] = ACPI_METHOD_PERFORMANCE_MODE " other",
+};
+static_assert(ARRAY_SIZE(galaxybook_op_names) == GB_OP_COUNT);
+
+static enum galaxybook_op galaxybook_sawb_op(enum galaxybook_method method_id,
+				const struct sawb *buf)
+{
+	if (method_id == GB_METHOD_PERFORMANCE_MODE) {
+		switch (buf->subn) {
+		case 0x01:
+			return GB_OP_PERFORMANCE_MODE_LIST;
+		case 0x02:
+			return GB_OP_PERFORMANCE_MODE_GET;
+		case 0x03:
+			return GB_OP_PERFORMANCE_MODE_SET;
+		default:
+			return GB_OP_PERFORMANCE_MODE_OTHER;
+		}
+	}
+
+	if (buf->gunm == 0xbb)
+		return GB_OP_ENABLE_FEATURE;
+
+	switch (buf->sasb) {
+	case SASB_KBD_BACKLIGHT:
+		return GB_OP_KBD_BACKLIGHT;
+	case SASB_POWER_MANAGEMENT:
+		if (buf->guds[0] == 0xa3)
+			return GB_OP_START_ON_LID_OPEN;
+		if (buf->guds[0] == 0xe9)
+			return GB_OP_BATTERY_THRESHOLD;
+		return GB_OP_SETTINGS_OTHER;
+	case SASB_USB_CHARGE_GET:
+	case SASB_USB_CHARGE_SET:
+		return GB_OP_USB_CHARGE;
+	case SASB_ALLOW_RECORDING:
+		return GB_OP_ALLOW_RECORDING;
+	case SASB_NOTIFICATIONS:
+		return GB_OP_NOTIFICATIONS;
+	default:
+		return GB_OP_SETTINGS_OTHER;
+	}
+}
+
+/* must be called with sawb_lock held */
+static void galaxybook_latency_record(struct samsung_galaxybook *galaxybook,
+				enum galaxybook_op op, u64 latency_ns, bool error)
+{
+	struct galaxybook_latency_hist *hist = &galaxybook->sawb_latency[op];
+	u64 latency_us = div_u64(latency_ns, NSEC_PER_USEC);
+	unsigned int bucket;
+
+	bucket = latency_us ? min(ilog2(latency_us) + 1, GB_LATENCY_BUCKETS - 1) : 0;
+
+	if (!hist->count || latency_ns < hist->min_ns)
+		hist->min_ns = latency_ns;
+	if (latency_ns > hist->max_ns)
+		hist->max_ns = latency_ns;
+	hist->total_ns += latency_ns;
+	hist->buckets[bucket]++;
+	hist->count++;
+	if (error)
+		hist->errors++;
+}
+
+static int sawb_latency_show(struct seq_file *m, void *v)
+{
+	struct samsung_galaxybook *galaxybook = m->private;
+	struct galaxybook_latency_hist *hist;
+	int op, i;
+
+	hist = kmalloc_array(GB_OP_COUNT, sizeof(*hist), GFP_KERNEL);
+	if (!hist)
+		return -ENOMEM;
+
+	mutex_lock(&galaxybook->sawb_lock);
+	memcpy(hist, galaxybook->sawb_latency, sizeof(*hist) * GB_OP_COUNT);
+	mutex_unlock(&galaxybook->sawb_lock);
+
+	for (op = 0; op < GB_OP_COUNT; op++) {
+		if (!hist[op].count)
+			continue;
+		seq_printf(m, "%s: count=%llu errors=%llu min_ns=%llu max_ns=%llu avg_ns=%llu\n",
+				galaxybook_op_names[op], hist[op].count, hist[op].errors,
+				hist[op].min_ns, hist[op].max_ns,
+				div64_u64(hist[op].total_ns, hist[op].count));
+		for (i = 0; i < GB_LATENCY_BUCKETS; i++) {
+			if (!hist[op].buckets[i])
+				continue;
+			if (i == 0)
+				seq_printf(m, "  %10s %6s us: %llu\n", "<", "1", hist[op].buckets[i]);
+			else if (i == GB_LATENCY_BUCKETS - 1)
+				seq_printf(m, "  %10s %6lu us: %llu\n", ">=", 1UL << (i - 1),
+						hist[op].buckets[i]);
+			else
+				seq_printf(m, "  %10lu-%6lu us: %llu\n", 1UL << (i - 1), 1UL << i,
+						hist[op].buckets[i]);
+		}
+	}
+
+	kfree(hist);
+	return 0;
+}
+
+static int sawb_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sawb_latency_show, inode->i_private);
+}
+
+/* writing anything to the file resets all histograms */
+static ssize_t sawb_latency_write(struct file *file, const char __user *ubuf, size_t count,
+				loff_t *ppos)
+{
+	struct samsung_galaxybook *galaxybook = ((struct seq_file *)file->private_data)->private;
+
+	mutex_lock(&galaxybook->sawb_lock);
+	memset(galaxybook->sawb_latency, 0, sizeof(galaxybook->sawb_latency));
+	mutex_unlock(&galaxybook->sawb_lock);
+
+	return count;
+}
+
+static const struct file_operations sawb_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = sawb_latency_open,
+	.read = seq_read,
+	.write = sawb_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/*
+ * Run one SAWB transaction. The response is written to a preallocated buffer and only the part of
+ * it given by ret_offset and ret_len (see SAWB_RET) is copied back into buf on success.
+ */
+static int galaxybook_acpi_method(struct samsung_galaxybook *galaxybook,
+				enum galaxybook_method method_id, struct sawb *buf, u32 len,
+				const char *purpose_str, size_t ret_offset, size_t ret_len)
 {
+	const char *method = galaxybook_method_names[method_id];
 	union acpi_object in_obj, *out_obj;
 	struct acpi_object_list input;
-	struct acpi_buffer output = {ACPI_ALLOCATE_BUFFER, NULL};
+	struct acpi_buffer output;
+	enum galaxybook_op op = galaxybook_sawb_op(method_id, buf);
 	acpi_status status;
+	u64 latency_ns;
+	int err = 0;
+
+	if (!galaxybook->methods[method_id])
+		return -ENODEV;
+	if (WARN_ON(ret_offset + ret_len > len))
+		return -EINVAL;
 
 	in_obj.type = ACPI_TYPE_BUFFER;
 	in_obj.buffer.length = len;
@@ -318,52 +877,67 @@ static int galaxybook_acpi_method(struct samsung_galaxybook *galaxybook, acpi_st
 	input.count = 1;
 	input.pointer = &in_obj;
 
-	debug_print_acpi_object_buffer(KERN_WARNING, purpose_str, &in_obj);
+	trace_galaxybook_sawb_request(method, buf->safn, buf->sasb, buf->gunm, buf->fncn, buf->subn);
 
-	status = acpi_evaluate_object(galaxybook->acpi->handle, method, &input, &output);
+	galaxybook_sawb_lock(galaxybook);
 
-	if (ACPI_SUCCESS(status)) {
-		out_obj = output.pointer;
-		if (out_obj->type != ACPI_TYPE_BUFFER) {
-			pr_err("failed %s with ACPI method %s; response was not a buffer\n",
-					purpose_str,
-					method);
-			status = -EIO;
-		} else {
-			debug_print_acpi_object_buffer(KERN_WARNING, "response was:", out_obj);
-		}
-		if (out_obj->buffer.length != len) {
-			pr_err("failed %s with ACPI method %s; response length mismatch\n",
-					purpose_str,
-					method);
-			status = -EIO;
-		} else if (out_obj->buffer.length < 6) {
-			pr_err("failed %s with ACPI method %s; response from device was too short\n",
-					purpose_str,
-					method);
-			status = -EIO;
-		} else if (out_obj->buffer.pointer[4] != 0xaa) {
-			pr_err("failed %s with ACPI method %s; device did not respond with success code 0xaa\n",
-					purpose_str,
-					method);
-			status = -EIO;
-		} else if (out_obj->buffer.pointer[5] == 0xff) {
-			pr_err("failed %s with ACPI method %s; device responded with failure code 0xff\n",
-					purpose_str,
-					method);
-			status = -EIO;
-		} else {
-			memcpy(ret, out_obj->buffer.pointer, len);
-		}
-		kfree(output.pointer);
-		return status;
-	} else {
+	output.length = sizeof(galaxybook->sawb_response);
+	output.pointer = &galaxybook->sawb_response;
+
+	latency_ns = ktime_get_ns();
+	status = acpi_evaluate_object(galaxybook->methods[method_id], NULL, &input, &output);
+	latency_ns = ktime_get_ns() - latency_ns;
+	if (ACPI_FAILURE(status)) {
 		pr_err("failed %s with ACPI method %s; got %s\n",
 				purpose_str,
 				method,
 				acpi_format_exception(status));
-		return status;
+		err = status;
+		trace_galaxybook_sawb_response(method, buf->sasb, NULL, 0, err, latency_ns);
+		goto out_unlock;
+	}
+
+	out_obj = output.pointer;
+	if (out_obj->type != ACPI_TYPE_BUFFER) {
+		pr_err("failed %s with ACPI method %s; response was not a buffer\n",
+				purpose_str,
+				method);
+		err = -EIO;
+		trace_galaxybook_sawb_response(method, buf->sasb, NULL, 0, err, latency_ns);
+		goto out_unlock;
+	}
+
+	if (out_obj->buffer.length != len) {
+		pr_err("failed %s with ACPI method %s; response length mismatch\n",
+				purpose_str,
+				method);
+		err = -EIO;
+	} else if (out_obj->buffer.length < 6) {
+		pr_err("failed %s with ACPI method %s; response from device was too short\n",
+				purpose_str,
+				method);
+		err = -EIO;
+	} else if (out_obj->buffer.pointer[4] != 0xaa) {
+		pr_err("failed %s with ACPI method %s; device did not respond with success code 0xaa\n",
+				purpose_str,
+				method);
+		err = -EIO;
+	} else if (out_obj->buffer.pointer[5] == 0xff) {
+		pr_err("failed %s with ACPI method %s; device responded with failure code 0xff\n",
+				purpose_str,
+				method);
+		err = -EIO;
+	} else if (ret_len) {
+		memcpy((u8 *) buf + ret_offset, out_obj->buffer.pointer + ret_offset, ret_len);
 	}
+
+	trace_galaxybook_sawb_response(method, buf->sasb, out_obj->buffer.pointer,
+			out_obj->buffer.length, err, latency_ns);
+
+out_unlock:
+	galaxybook_latency_record(galaxybook, op, latency_ns, err != 0);
+	galaxybook_sawb_unlock(galaxybook);
+	return err;
 }
 
 static int galaxybook_enable_acpi_feature(struct samsung_galaxybook *galaxybook, const u16 sasb)
@@ -376,8 +950,9 @@ static int galaxybook_enable_acpi_feature(struct samsung_galaxybook *galaxybook,
 	buf.gunm = 0xbb;
 	buf.guds[0] = 0xaa;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"enabling ACPI feature", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"enabling ACPI feature",
+			offsetof(struct sawb, gunm), 2);
 	if (err)
 		return err;
 
@@ -388,6 +963,40 @@ static int galaxybook_enable_acpi_feature(struct samsung_galaxybook *galaxybook,
 }
 
 
+/*
+ * Settings cache
+ *
+ * Every CSFI call triggers an SMI, so the current value of each setting is kept in the driver and
+ * only read from the device again after an event which could have changed it behind our back.
+ */
+
+static void galaxybook_cache_invalidate(struct samsung_galaxybook *galaxybook, unsigned long items)
+{
+	unsigned int item;
+
+	if (debug_enabled())
+		pr_warn("[DEBUG] invalidating cached settings 0x%lx\n", items & galaxybook->cache_valid);
+	/* waits for reads in progress, which would otherwise mark their older value valid again */
+	for_each_set_bit(item, &items, GB_CACHE_COUNT) {
+		mutex_lock(&galaxybook->cache_locks[item]);
+		clear_bit(item, &galaxybook->cache_valid);
+		mutex_unlock(&galaxybook->cache_locks[item]);
+	}
+}
+
+static inline void galaxybook_cache_update(struct samsung_galaxybook *galaxybook,
+				enum galaxybook_cache_item item)
+{
+	set_bit(item, &galaxybook->cache_valid);
+}
+
+static inline bool galaxybook_cache_valid(struct samsung_galaxybook *galaxybook,
+				enum galaxybook_cache_item item)
+{
+	return test_bit(item, &galaxybook->cache_valid);
+}
+
+
 /*
  * Keyboard Backlight
  */
@@ -404,40 +1013,54 @@ static int kbd_backlight_acpi_set(struct samsung_galaxybook *galaxybook,
 
 	buf.guds[0] = brightness;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"setting kbd_backlight brightness", &buf);
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_KBD_BACKLIGHT]);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"setting kbd_backlight brightness", SAWB_RET_NONE);
 	if (err)
-		return err;
+		goto out_unlock;
 
-	galaxybook->kbd_backlight.brightness = brightness;
+	galaxybook->kbd_backlight_brightness = brightness;
+	galaxybook_cache_update(galaxybook, GB_CACHE_KBD_BACKLIGHT);
 
 	pr_info("set kbd_backlight brightness to %d\n", brightness);
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_KBD_BACKLIGHT]);
+	return err;
 }
 
 static int kbd_backlight_acpi_get(struct samsung_galaxybook *galaxybook,
 				enum led_brightness *brightness)
 {
 	struct sawb buf = {0};
-	int err;
+	int err = 0;
+
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_KBD_BACKLIGHT]);
+
+	if (galaxybook_cache_valid(galaxybook, GB_CACHE_KBD_BACKLIGHT)) {
+		*brightness = galaxybook->kbd_backlight_brightness;
+		goto out_unlock;
+	}
 
 	buf.safn = SAFN;
 	buf.sasb = SASB_KBD_BACKLIGHT;
 	buf.gunm = GUNM_GET;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"getting kbd_backlight brightness", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"getting kbd_backlight brightness", SAWB_RET(gunm));
 	if (err)
-		return err;
+		goto out_unlock;
 
 	*brightness = buf.gunm;
-	galaxybook->kbd_backlight.brightness = buf.gunm;
+	galaxybook->kbd_backlight_brightness = buf.gunm;
+	galaxybook_cache_update(galaxybook, GB_CACHE_KBD_BACKLIGHT);
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] current kbd_backlight brightness is %d\n", buf.gunm);
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_KBD_BACKLIGHT]);
+	return err;
 }
 
 static int kbd_backlight_store(struct led_classdev *led,
@@ -515,20 +1138,33 @@ static int start_on_lid_open_acpi_set(struct samsung_galaxybook *galaxybook, con
 	buf.guds[1] = 0x80;
 	buf.guds[2] = value;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"setting start_on_lid_open", &buf);
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_START_ON_LID_OPEN]);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"setting start_on_lid_open", SAWB_RET_NONE);
 	if (err)
-		return err;
+		goto out_unlock;
+
+	galaxybook->start_on_lid_open = value;
+	galaxybook_cache_update(galaxybook, GB_CACHE_START_ON_LID_OPEN);
 
 	pr_info("turned start_on_lid_open %s\n", value ? "on (1)" : "off (0)");
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_START_ON_LID_OPEN]);
+	return err;
 }
 
 static int start_on_lid_open_acpi_get(struct samsung_galaxybook *galaxybook, bool *value)
 {
 	struct sawb buf = {0};
-	int err;
+	int err = 0;
+
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_START_ON_LID_OPEN]);
+
+	if (galaxybook_cache_valid(galaxybook, GB_CACHE_START_ON_LID_OPEN)) {
+		*value = galaxybook->start_on_lid_open;
+		goto out_unlock;
+	}
 
 	buf.safn = SAFN;
 	buf.sasb = SASB_POWER_MANAGEMENT;
@@ -536,18 +1172,22 @@ static int start_on_lid_open_acpi_get(struct samsung_galaxybook *galaxybook, boo
 	buf.guds[0] = 0xa3;
 	buf.guds[1] = 0x81;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"getting start_on_lid_open", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"getting start_on_lid_open", SAWB_RET(guds[1]));
 	if (err)
-		return err;
+		goto out_unlock;
 
 	*value = buf.guds[1];
+	galaxybook->start_on_lid_open = *value;
+	galaxybook_cache_update(galaxybook, GB_CACHE_START_ON_LID_OPEN);
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] start_on_lid_open is currently %s\n",
 				(buf.guds[1] ? "on (1)" : "off (0)"));
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_START_ON_LID_OPEN]);
+	return err;
 }
 
 static ssize_t start_on_lid_open_store(struct device *dev, struct device_attribute *attr,
@@ -597,37 +1237,54 @@ static int usb_charge_acpi_set(struct samsung_galaxybook *galaxybook, const bool
 	/* gunm value should be 0x81 to turn on and 0x80 to turn off */
 	buf.gunm = value ? 0x81 : 0x80;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"setting usb_charge", &buf);
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_USB_CHARGE]);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"setting usb_charge", SAWB_RET_NONE);
 	if (err)
-		return err;
+		goto out_unlock;
+
+	galaxybook->usb_charge = value;
+	galaxybook_cache_update(galaxybook, GB_CACHE_USB_CHARGE);
 
 	pr_info("turned usb_charge %s\n", value ? "on (1)" : "off (0)");
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_USB_CHARGE]);
+	return err;
 }
 
 static int usb_charge_acpi_get(struct samsung_galaxybook *galaxybook, bool *value)
 {
 	struct sawb buf = {0};
-	int err;
+	int err = 0;
+
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_USB_CHARGE]);
+
+	if (galaxybook_cache_valid(galaxybook, GB_CACHE_USB_CHARGE)) {
+		*value = galaxybook->usb_charge;
+		goto out_unlock;
+	}
 
 	buf.safn = SAFN;
 	buf.sasb = SASB_USB_CHARGE_GET;
 	buf.gunm = 0x80;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"getting usb_charge", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"getting usb_charge", SAWB_RET(gunm));
 	if (err)
-		return err;
+		goto out_unlock;
 
 	*value = buf.gunm;
+	galaxybook->usb_charge = *value;
+	galaxybook_cache_update(galaxybook, GB_CACHE_USB_CHARGE);
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] usb_charge is currently %s\n",
 				(buf.gunm ? "on (1)" : "off (0)"));
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_USB_CHARGE]);
+	return err;
 }
 
 static ssize_t usb_charge_store(struct device *dev, struct device_attribute *attr,
@@ -665,6 +1322,18 @@ static DEVICE_ATTR_RW(usb_charge);
 
 /* Allow recording (allows or blocks access to camera and microphone) */
 
+/* blocked recording is reported as the camera lens being covered and the microphone muted */
+static void allow_recording_input_report(struct samsung_galaxybook *galaxybook, const bool value)
+{
+	mutex_lock(&galaxybook->input_lock);
+	if (galaxybook->input) {
+		input_report_switch(galaxybook->input, SW_CAMERA_LENS_COVER, !value);
+		input_report_switch(galaxybook->input, SW_MUTE_DEVICE, !value);
+		input_sync(galaxybook->input);
+	}
+	mutex_unlock(&galaxybook->input_lock);
+}
+
 static int allow_recording_acpi_set(struct samsung_galaxybook *galaxybook, const bool value)
 {
 	struct sawb buf = {0};
@@ -675,37 +1344,56 @@ static int allow_recording_acpi_set(struct samsung_galaxybook *galaxybook, const
 	buf.gunm = GUNM_SET;
 	buf.guds[0] = value;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"setting allow_recording", &buf);
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_ALLOW_RECORDING]);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"setting allow_recording", SAWB_RET_NONE);
 	if (err)
-		return err;
+		goto out_unlock;
+
+	galaxybook->allow_recording = value;
+	galaxybook_cache_update(galaxybook, GB_CACHE_ALLOW_RECORDING);
+	allow_recording_input_report(galaxybook, value);
 
 	pr_info("turned allow_recording %s\n", value ? "on (1)" : "off (0)");
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_ALLOW_RECORDING]);
+	return err;
 }
 
 static int allow_recording_acpi_get(struct samsung_galaxybook *galaxybook, bool *value)
 {
 	struct sawb buf = {0};
-	int err;
+	int err = 0;
+
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_ALLOW_RECORDING]);
+
+	if (galaxybook_cache_valid(galaxybook, GB_CACHE_ALLOW_RECORDING)) {
+		*value = galaxybook->allow_recording;
+		goto out_unlock;
+	}
 
 	buf.safn = SAFN;
 	buf.sasb = SASB_ALLOW_RECORDING;
 	buf.gunm = GUNM_GET;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"getting allow_recording", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"getting allow_recording", SAWB_RET(gunm));
 	if (err)
-		return err;
+		goto out_unlock;
 
 	*value = buf.gunm;
+	galaxybook->allow_recording = *value;
+	galaxybook_cache_update(galaxybook, GB_CACHE_ALLOW_RECORDING);
+	allow_recording_input_report(galaxybook, *value);
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] allow_recording is currently %s\n",
 				(buf.gunm ? "on (1)" : "off (0)"));
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_ALLOW_RECORDING]);
+	return err;
 }
 
 static ssize_t allow_recording_store(struct device *dev, struct device_attribute *attr,
@@ -798,20 +1486,33 @@ static int charge_control_end_threshold_acpi_set(struct samsung_galaxybook *gala
 
 	buf.guds[2] = (value == 100 ? 0 : value);
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"setting battery charge_control_end_threshold", &buf);
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_CHARGE_CONTROL_END_THRESHOLD]);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"setting battery charge_control_end_threshold", SAWB_RET_NONE);
 	if (err)
-		return err;
+		goto out_unlock;
+
+	galaxybook->charge_control_end_threshold = (value == 100 ? 0 : value);
+	galaxybook_cache_update(galaxybook, GB_CACHE_CHARGE_CONTROL_END_THRESHOLD);
 
 	pr_info("set battery charge_control_end_threshold to %d\n", (value == 100 ? 0 : value));
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_CHARGE_CONTROL_END_THRESHOLD]);
+	return err;
 }
 
 static int charge_control_end_threshold_acpi_get(struct samsung_galaxybook *galaxybook, u8 *value)
 {
 	struct sawb buf = {0};
-	int err;
+	int err = 0;
+
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_CHARGE_CONTROL_END_THRESHOLD]);
+
+	if (galaxybook_cache_valid(galaxybook, GB_CACHE_CHARGE_CONTROL_END_THRESHOLD)) {
+		*value = galaxybook->charge_control_end_threshold;
+		goto out_unlock;
+	}
 
 	buf.safn = SAFN;
 	buf.sasb = SASB_POWER_MANAGEMENT;
@@ -819,19 +1520,24 @@ static int charge_control_end_threshold_acpi_get(struct samsung_galaxybook *gala
 	buf.guds[0] = 0xe9;
 	buf.guds[1] = 0x91;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"getting battery charge_control_end_threshold", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"getting battery charge_control_end_threshold",
+			SAWB_RET(guds[1]));
 	if (err)
-		return err;
+		goto out_unlock;
 
 	*value = buf.guds[1];
+	galaxybook->charge_control_end_threshold = *value;
+	galaxybook_cache_update(galaxybook, GB_CACHE_CHARGE_CONTROL_END_THRESHOLD);
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] battery charge control is currently %s; " \
 				"battery charge_control_end_threshold is %d\n",
 				(buf.guds[1] > 0 ? "on" : "off"), buf.guds[1]);
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_CHARGE_CONTROL_END_THRESHOLD]);
+	return err;
 }
 
 static ssize_t charge_control_end_threshold_store(struct device *dev, struct device_attribute *attr,
@@ -867,16 +1573,56 @@ static DEVICE_ATTR_RW(charge_control_end_threshold);
 
 static int galaxybook_battery_add(struct power_supply *battery, struct acpi_battery_hook *hook)
 {
+	struct samsung_galaxybook *galaxybook = galaxybook_ptr;
+	int i;
+
 	if (device_create_file(&battery->dev, &dev_attr_charge_control_end_threshold))
 		return -ENODEV;
+
+	mutex_lock(&galaxybook->batteries_lock);
+	for (i = 0; i < MAX_BATTERY_COUNT; i++) {
+		if (!galaxybook->batteries[i]) {
+			galaxybook->batteries[i] = battery;
+			break;
+		}
+	}
+	mutex_unlock(&galaxybook->batteries_lock);
+
+	if (i == MAX_BATTERY_COUNT)
+		pr_warn("battery %s will not be notified of battery state changes\n",
+				battery->desc->name);
+
 	return 0;
 }
 
 static int galaxybook_battery_remove(struct power_supply *battery, struct acpi_battery_hook *hook)
 {
-	device_remove_file(&battery->dev, &dev_attr_charge_control_end_threshold);
-	return 0;
-}
+	struct samsung_galaxybook *galaxybook = galaxybook_ptr;
+	int i;
+
+	mutex_lock(&galaxybook->batteries_lock);
+	for (i = 0; i < MAX_BATTERY_COUNT; i++) {
+		if (galaxybook->batteries[i] == battery)
+			galaxybook->batteries[i] = NULL;
+	}
+	mutex_unlock(&galaxybook->batteries_lock);
+
+	device_remove_file(&battery->dev, &dev_attr_charge_control_end_threshold);
+	return 0;
+}
+
+/* let power_supply push a uevent now instead of userspace noticing on its next poll */
+static void galaxybook_battery_notify(struct samsung_galaxybook *galaxybook)
+{
+	int i;
+
+	mutex_lock(&galaxybook->batteries_lock);
+	for (i = 0; i < MAX_BATTERY_COUNT; i++) {
+		if (galaxybook->batteries[i])
+			power_supply_changed(galaxybook->batteries[i]);
+	}
+	mutex_unlock(&galaxybook->batteries_lock);
+}
 
 static struct acpi_battery_hook galaxybook_battery_hook = {
 	.add_battery = galaxybook_battery_add,
@@ -891,12 +1637,13 @@ static struct acpi_battery_hook galaxybook_battery_hook = {
 
 static int fan_speed_get_fst(struct galaxybook_fan *fan, unsigned int *speed)
 {
-	struct acpi_buffer response = { ACPI_ALLOCATE_BUFFER, NULL };
+	/* _FST returns a package of 3 integers, which fits on the stack (package object + elements) */
+	union acpi_object response_objs[4];
+	struct acpi_buffer response = { sizeof(response_objs), response_objs };
 	union acpi_object *response_obj = NULL;
 	acpi_status status;
-	int ret = 0;
 
-	status = acpi_evaluate_object(fan->fan.handle, "_FST", NULL, &response);
+	status = acpi_evaluate_object(fan->fst, NULL, NULL, &response);
 	if (ACPI_FAILURE(status)) {
 		pr_err("Get fan state failed\n");
 		return -ENODEV;
@@ -907,63 +1654,219 @@ static int fan_speed_get_fst(struct galaxybook_fan *fan, unsigned int *speed)
 			response_obj->package.count != 3 ||
 			response_obj->package.elements[2].type != ACPI_TYPE_INTEGER) {
 		pr_err("Invalid _FST data\n");
-		ret = -EINVAL;
-		goto out_free;
+		return -EINVAL;
 	}
 
 	*speed = response_obj->package.elements[2].integer.value;
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] reporting fan_speed of %d\n", *speed);
 
-out_free:
-	ACPI_FREE(response.pointer);
-	return ret;
+	return 0;
 }
 
-static int fan_speed_get_fans(struct galaxybook_fan *fan, unsigned int *speed)
+static int galaxybook_ec_field_read(const struct galaxybook_ec_field *field,
+				unsigned long long *value)
+{
+	u8 byte;
+	int err;
+
+	err = ec_read(field->offset, &byte);
+	if (err)
+		return err;
+
+	*value = (byte >> field->shift) & field->mask;
+	return 0;
+}
+
+/* a value read at or after not_before is reused, so one read serves all fans sharing the field */
+static int galaxybook_field_read(struct galaxybook_field *field, u64 not_before,
+				unsigned long long *value)
 {
-	struct acpi_buffer response = { ACPI_ALLOCATE_BUFFER, NULL };
-	union acpi_object *response_obj = NULL;
 	acpi_status status;
-	int ret = 0;
-	int speed_level = -1;
+	u64 read_at;
+	int err = -ENODEV;
 
-	status = acpi_evaluate_object(NULL, ACPI_FAN_SPEED_VALUE, NULL, &response);
-	if (ACPI_FAILURE(status)) {
-		pr_err("Get fan state failed\n");
-		return -ENODEV;
+	mutex_lock(&field->lock);
+
+	if (field->valid && field->read_at >= not_before) {
+		*value = field->value;
+		mutex_unlock(&field->lock);
+		return 0;
 	}
 
-	response_obj = response.pointer;
-	if (!response_obj ||
-			response_obj->type != ACPI_TYPE_INTEGER ||
-			response_obj->integer.value > INT_MAX ||
-			(int) response_obj->integer.value > fan->fan_speeds_count) {
+	read_at = ktime_get_ns();
+
+	if (field->ec) {
+		err = galaxybook_ec_field_read(field->ec, value);
+		if (err && debug_enabled())
+			pr_warn("[DEBUG] reading %s from EC failed (%d); falling back to ACPI\n",
+					field->name, err);
+	}
+
+	if (err) {
+		status = acpi_evaluate_integer(field->handle, NULL, NULL, value);
+		if (ACPI_FAILURE(status)) {
+			pr_err_ratelimited("failed to read %s\n", field->name);
+			field->valid = false;
+			mutex_unlock(&field->lock);
+			return -ENODEV;
+		}
+	}
+
+	field->valid = true;
+	field->read_at = read_at;
+	field->value = *value;
+
+	mutex_unlock(&field->lock);
+
+	return 0;
+}
+
+static int fan_speed_get_fans(struct galaxybook_fan *fan, u64 not_before, unsigned int *speed,
+				int *level)
+{
+	unsigned long long value;
+	int speed_level = -1;
+	int err;
+
+	err = galaxybook_field_read(fan->field, not_before, &value);
+	if (err)
+		return err;
+
+	if (value >= fan->fan_speeds_count) {
 		pr_err("invalid fan speed data\n");
-		ret = -EINVAL;
-		goto out_free;
+		return -EINVAL;
 	}
 
-	speed_level = (int) response_obj->integer.value;
+	speed_level = (int) value;
 	*speed = fan->fan_speeds[speed_level];
+	*level = speed_level;
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] reporting fan_speed of %d (level %d)\n", *speed, speed_level);
 
-out_free:
-	ACPI_FREE(response.pointer);
+	return 0;
+}
+
+/* must be called with sample_lock held */
+static void fan_stats_update(struct galaxybook_fan *fan, int level, unsigned int speed, u64 now)
+{
+	unsigned int key = level >= 0 ? level : rounddown(speed, FAN_STATS_RPM_BUCKET);
+	int state = FAN_STATS_OTHER;
+
+	/* the time since the previous sample is counted towards the state seen then */
+	if (fan->stats_state >= 0)
+		fan->stats_time_ns[fan->stats_state] += now - fan->stats_since;
+
+	if (level >= 0) {
+		/* levels are their own index, so that all levels up to the highest seen are listed */
+		if (level < FAN_LEVELS_MAX) {
+			state = level;
+			for (int i = fan->stats_count; i <= level; i++)
+				fan->stats_keys[i] = i;
+			fan->stats_count = max(fan->stats_count, level + 1);
+		}
+	} else {
+		for (int i = 0; i < fan->stats_count; i++) {
+			if (fan->stats_keys[i] == key) {
+				state = i;
+				break;
+			}
+		}
+		if (state == FAN_STATS_OTHER && fan->stats_count < FAN_LEVELS_MAX) {
+			state = fan->stats_count++;
+			fan->stats_keys[state] = key;
+		}
+	}
+
+	/* compared by key, so that changes between states counted as "other" still show up */
+	if (fan->stats_state >= 0 && key != fan->stats_key)
+		fan->stats_transitions++;
+
+	fan->stats_state = state;
+	fan->stats_key = key;
+	fan->stats_since = now;
+}
+
+/* must be called with sample_lock held */
+static void fan_stats_reset(struct galaxybook_fan *fan, u64 now)
+{
+	memset(fan->stats_time_ns, 0, sizeof(fan->stats_time_ns));
+	fan->stats_transitions = 0;
+	/* keep the current state so that counting continues from now */
+	fan->stats_since = now;
+}
+
+/*
+ * a sample taken at or after not_before is reused; level is only known for fans using a level
+ * field, and is -1 for fans using _FST
+ */
+static int fan_speed_read(struct galaxybook_fan *fan, u64 not_before, unsigned int *speed,
+				int *level, u64 *timestamp)
+{
+	u64 start;
+	int ret;
+
+	*level = -1;
+
+	/*
+	 * readers arriving while another reader is evaluating wait on sample_lock and then
+	 * pick up the fresh sample instead of evaluating the same AML again
+	 */
+	mutex_lock(&fan->sample_lock);
+
+	start = ktime_get_ns();
+	if (fan->sample_valid && fan->sampled_at >= not_before) {
+		*speed = fan->sample_speed;
+		*level = fan->sample_level;
+		*timestamp = fan->sampled_at;
+		mutex_unlock(&fan->sample_lock);
+		return 0;
+	}
+
+	if (fan->supports_fst)
+		ret = fan_speed_get_fst(fan, speed);
+	else
+		ret = fan_speed_get_fans(fan, not_before, speed, level);
+
+	trace_galaxybook_fan_read(fan - galaxybook_ptr->fans, *level, ret ? 0 : *speed, ret,
+			ktime_get_ns() - start);
+
+	/* failures are not cached so that the next reader tries again */
+	fan->sample_valid = !ret;
+	if (!ret) {
+		fan->sampled_at = start;
+		fan->sample_speed = *speed;
+		fan->sample_level = *level;
+		*timestamp = start;
+		fan_stats_update(fan, *level, *speed, start);
+	}
+
+	mutex_unlock(&fan->sample_lock);
+
 	return ret;
 }
 
+/* samples taken at or after this are still within fan_update_interval_ms */
+static u64 galaxybook_sample_not_before(struct samsung_galaxybook *galaxybook)
+{
+	u64 interval_ns = (u64)READ_ONCE(galaxybook->fan_update_interval_ms) * NSEC_PER_MSEC;
+	u64 now = ktime_get_ns();
+
+	return now > interval_ns ? now - interval_ns : 0;
+}
+
 static int fan_speed_get(struct galaxybook_fan *fan, unsigned int *speed)
 {
+	u64 timestamp;
+	int level;
+
 	if (!fan)
 		return -ENODEV;
-	if (fan->supports_fst)
-		return fan_speed_get_fst(fan, speed);
-	else
-		return fan_speed_get_fans(fan, speed);
+
+	return fan_speed_read(fan, galaxybook_sample_not_before(galaxybook_ptr), speed, &level,
+			&timestamp);
 }
 
 static ssize_t fan_speed_rpm_show(struct device *dev, struct device_attribute *attr, char *buffer)
@@ -983,6 +1886,43 @@ static ssize_t fan_speed_rpm_show(struct device *dev, struct device_attribute *a
 	return sysfs_emit(buffer, "%u\n", speed);
 }
 
+/*
+ * replace the speeds of levels 0 through count - 1 (adding levels if count is larger than what
+ * FANT gave) with measured values written to the hwmon fan*_levels attribute
+ */
+static int fan_speed_list_set(struct galaxybook_fan *fan, const unsigned int *speeds, int count)
+{
+	unsigned int *fan_speeds, *old_speeds;
+	int fan_speeds_count;
+
+	if (count < 1 || count > FAN_LEVELS_MAX)
+		return -EINVAL;
+
+	mutex_lock(&fan->sample_lock);
+
+	/* levels which are not given keep their current speed */
+	fan_speeds_count = max(count, fan->fan_speeds_count);
+	fan_speeds = kcalloc(fan_speeds_count, sizeof(*fan_speeds), GFP_KERNEL);
+	if (!fan_speeds) {
+		mutex_unlock(&fan->sample_lock);
+		return -ENOMEM;
+	}
+	if (fan->fan_speeds)
+		memcpy(fan_speeds, fan->fan_speeds, fan->fan_speeds_count * sizeof(*fan_speeds));
+	memcpy(fan_speeds, speeds, count * sizeof(*fan_speeds));
+
+	old_speeds = fan->fan_speeds;
+	fan->fan_speeds = fan_speeds;
+	fan->fan_speeds_count = fan_speeds_count;
+	/* the cached speed was looked up in the old list */
+	fan->sample_valid = false;
+
+	mutex_unlock(&fan->sample_lock);
+
+	kfree(old_speeds);
+	return 0;
+}
+
 static int __init fan_speed_list_init(acpi_handle handle, struct galaxybook_fan *fan)
 {
 	struct acpi_buffer response = { ACPI_ALLOCATE_BUFFER, NULL };
@@ -1041,7 +1981,7 @@ static int __init fan_speed_list_init(acpi_handle handle, struct galaxybook_fan
 	}
 
 	pr_info("initialized fan speed reporting for device %s (%s) with the following levels:\n",
-			dev_name(&fan->fan.dev), fan->description);
+			dev_name(&fan->adev->dev), fan->description);
 	for (i = 0; i < fan->fan_speeds_count; i++)
 		pr_info("  fan speed level %d = %d\n", i, fan->fan_speeds[i]);
 
@@ -1051,14 +1991,196 @@ out_free:
 
 err_fan_speeds_free:
 	kfree(fan->fan_speeds);
+	fan->fan_speeds = NULL;
+	fan->fan_speeds_count = 0;
 	goto out_free;
 }
 
+static acpi_status galaxybook_find_ec_field(acpi_handle handle, u32 level, void *context,
+				void **return_value)
+{
+	const char *name = context;
+	acpi_handle field;
+
+	if (ACPI_FAILURE(acpi_get_handle(handle, name, &field)))
+		return AE_OK;
+
+	*return_value = field;
+	return AE_CTRL_TERMINATE;
+}
+
+/* fields like FANS are on the EC, but the path to the EC device varies between models */
+static acpi_handle galaxybook_ec_field_handle(const char *name)
+{
+	acpi_handle field = NULL;
+
+	acpi_get_devices(ACPI_EC_DEVICE_ID, galaxybook_find_ec_field, (void *)name, &field);
+
+	return field;
+}
+
+static const struct galaxybook_ec_field *galaxybook_ec_field_lookup(const char *name,
+				const struct dmi_system_id **dmi_id)
+{
+	const struct galaxybook_ec_field *field;
+
+	*dmi_id = dmi_first_match(galaxybook_ec_dmi_ids);
+	if (!*dmi_id)
+		return NULL;
+
+	for (field = (*dmi_id)->driver_data; field->name; field++) {
+		if (!strcmp(field->name, name))
+			return field;
+	}
+
+	return NULL;
+}
+
+/* the value can change in between, so a match with either ACPI reading is enough */
+static int galaxybook_ec_field_verify(const struct galaxybook_ec_field *ec_field,
+				unsigned long long *value)
+{
+	unsigned long long before, after;
+	acpi_handle handle;
+
+	handle = galaxybook_ec_field_handle(ec_field->name);
+	if (!handle)
+		return -ENODEV;
+
+	if (ACPI_FAILURE(acpi_evaluate_integer(handle, NULL, NULL, &before)) ||
+			galaxybook_ec_field_read(ec_field, value) ||
+			ACPI_FAILURE(acpi_evaluate_integer(handle, NULL, NULL, &after)))
+		return -EIO;
+
+	if (*value != before && *value != after) {
+		pr_warn("%s from EC offset 0x%02x (%llu) does not match ACPI (%llu)\n",
+				ec_field->name, ec_field->offset, *value, after);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * One field alone says little about its location: FANS is 4 bits and usually 0 while the fan is
+ * idle, which a wrong offset would match just as well. So every field in the layout has to agree
+ * with ACPI, and at least one of them has to be nonzero, before any of them is read from the EC.
+ */
+static int galaxybook_ec_layout_verify(const struct galaxybook_ec_field *layout)
+{
+	const struct galaxybook_ec_field *ec_field;
+	unsigned long long value;
+	bool nonzero = false;
+	int err;
+
+	for (ec_field = layout; ec_field->name; ec_field++) {
+		err = galaxybook_ec_field_verify(ec_field, &value);
+		if (err)
+			return err;
+		nonzero |= value != 0;
+	}
+
+	return nonzero ? 0 : -ENODATA;
+}
+
+/* use ec_read() for the field only if the model is known and its layout agrees with ACPI now */
+static void galaxybook_field_ec_init(struct galaxybook_field *field)
+{
+	const struct galaxybook_ec_field *ec_field;
+	const struct dmi_system_id *dmi_id;
+	int err;
+
+	ec_field = galaxybook_ec_field_lookup(field->name, &dmi_id);
+	if (!ec_field) {
+		pr_info("EC location of %s is not known for this model; it will be read using ACPI\n",
+				field->name);
+		return;
+	}
+
+	err = galaxybook_ec_layout_verify(dmi_id->driver_data);
+	if (err) {
+		pr_warn("unable to verify EC location of %s (%d); it will be read using ACPI\n",
+				field->name, err);
+		if (err == -EINVAL)
+			pr_warn_create_issue();
+		return;
+	}
+
+	field->ec = ec_field;
+	pr_info("reading %s directly from EC offset 0x%02x for %s\n",
+			field->name, ec_field->offset, dmi_id->ident);
+}
+
+/*
+ * EC field holding the current level of each fan device (by ACPI bus id), for models with a
+ * separate level field per fan; fans which are not listed use FANS. None of the models in dsdt/
+ * have a second level field, so there are no entries yet.
+ */
+struct galaxybook_fan_level_field {
+	const char *fan;
+	const char *field;
+};
+
+static const struct galaxybook_fan_level_field galaxybook_fan_level_fields[] = {
+	{ },
+};
+
+static const char *galaxybook_fan_level_field_name(struct acpi_device *adev)
+{
+	const struct galaxybook_fan_level_field *entry;
+
+	for (entry = galaxybook_fan_level_fields; entry->fan; entry++) {
+		if (!strcmp(entry->fan, acpi_device_bid(adev)))
+			return entry->field;
+	}
+
+	return ACPI_FAN_SPEED_VALUE;
+}
+
+/* find the EC field with this name, or set it up if nothing is using it yet */
+static struct galaxybook_field *galaxybook_field_get(struct samsung_galaxybook *galaxybook,
+				const char *name)
+{
+	struct galaxybook_field *field;
+	acpi_handle handle;
+
+	handle = galaxybook_ec_field_handle(name);
+	if (!handle)
+		return NULL;
+
+	for (int i = 0; i < galaxybook->fields_count; i++) {
+		if (galaxybook->fields[i].handle == handle)
+			return &galaxybook->fields[i];
+	}
+
+	if (galaxybook->fields_count >= galaxybook->fields_allocated)
+		return NULL;
+
+	field = &galaxybook->fields[galaxybook->fields_count++];
+	field->name = name;
+	field->handle = handle;
+	mutex_init(&field->lock);
+	galaxybook_field_ec_init(field);
+
+	return field;
+}
+
+/* drop everything held by a fan slot and leave it zeroed so that the slot can be reused */
+static void galaxybook_fan_release(struct galaxybook_fan *fan)
+{
+	mutex_destroy(&fan->sample_lock);
+	kfree(fan->fan_speeds);
+	kfree(fan->description);
+	acpi_dev_put(fan->adev);
+	memset(fan, 0, sizeof(*fan));
+}
+
 static acpi_status galaxybook_add_fan(acpi_handle handle, u32 level, void *context,
 				void **return_value)
 {
 	struct acpi_device *adev = acpi_fetch_acpi_dev(handle);
 	struct samsung_galaxybook *galaxybook = context;
+	const char *level_field = galaxybook_fan_level_field_name(adev);
 	struct galaxybook_fan *fan;
 	int speed = -1;
 
@@ -1074,53 +2196,62 @@ static acpi_status galaxybook_add_fan(acpi_handle handle, u32 level, void *conte
 		return 0;
 	}
 
-	if (galaxybook->fans_count >= MAX_FAN_COUNT) {
-		pr_err("maximum number of %d fans has already been reached\n", MAX_FAN_COUNT);
+	/* can only happen if a fan device appeared after galaxybook_count_fans */
+	if (galaxybook->fans_count >= galaxybook->fans_allocated) {
+		pr_err("no room left for fan device %s\n", dev_name(&adev->dev));
 		pr_warn_create_issue();
 		return 0;
 	}
 
 	fan = &galaxybook->fans[galaxybook->fans_count];
-	fan->fan = *adev;
-	fan->description = get_acpi_device_description(&fan->fan);
-
+	fan->adev = acpi_dev_get(adev);
+	fan->description = get_acpi_device_description(fan->adev);
+	/* fan_speed_rpm can be read as soon as it is created below, so this must come first */
+	mutex_init(&fan->sample_lock);
+	fan->sample_valid = false;
+	fan->stats_state = -1;
+
+	/* resolve handles once here so that reading the speed later does not walk the namespace */
+	if (ACPI_FAILURE(acpi_get_handle(handle, "_FST", &fan->fst)))
+		fan->fst = NULL;
 	/* try to get speed from _FST */
-	if (ACPI_FAILURE(fan_speed_get_fst(fan, &speed))) {
+	if (!fan->fst || ACPI_FAILURE(fan_speed_get_fst(fan, &speed))) {
 		pr_info("_FST is present but failed on fan device %s (%s); " \
 				"will attempt to add fan speed support using FANT and FANS\n",
-				dev_name(&fan->fan.dev), fan->description);
+				dev_name(&fan->adev->dev), fan->description);
 		fan->supports_fst = false;
 	}
 	/* if speed was 0 and FANT and FANS exist, they should be used anyway due to bugs in ACPI */
 	else if (speed <= 0 &&
 			acpi_has_method(handle, ACPI_FAN_SPEED_LIST) &&
-			acpi_has_method(NULL, ACPI_FAN_SPEED_VALUE)) {
+			galaxybook_ec_field_handle(level_field)) {
 		pr_info("_FST is present on fan device %s (%s) but returned value of 0; " \
 				"will attempt to add fan speed support using FANT and FANS\n",
-				dev_name(&fan->fan.dev), fan->description);
+				dev_name(&fan->adev->dev), fan->description);
 		fan->supports_fst = false;
 	} else {
 		fan->supports_fst = true;
 	}
 
 	if (!fan->supports_fst) {
-		/* since FANS is a single field on the EC, it does not make sense to use more than once */
-		for (int i = 0; i < galaxybook->fans_count; i++) {
-			if (!galaxybook->fans[i].supports_fst) {
-				pr_err("more than one fan using FANS is not supported\n");
-				pr_warn_create_issue();
-				return 0;
-			}
+		/* only bound here, so that fans using _FST do not add to every field refresh */
+		fan->field = galaxybook_field_get(galaxybook, level_field);
+		if (!fan->field) {
+			pr_err("no %s field was found for fan device %s (%s)\n", level_field,
+					dev_name(&fan->adev->dev), fan->description);
+			goto err_release;
 		}
+		pr_info("found %s field for fan device %s\n", fan->field->name,
+				dev_name(&adev->dev));
 		if (ACPI_FAILURE(fan_speed_list_init(handle, fan))) {
 			pr_err("unable to get list of fan speeds for fan device %s (%s)\n",
-					dev_name(&fan->fan.dev), fan->description);
+					dev_name(&fan->adev->dev), fan->description);
 			pr_warn_create_issue();
-			return 0;
+			goto err_release;
 		}
 	} else {
 		pr_info("initialized fan speed reporting for device %s (%s) using method _FST\n",
-				dev_name(&fan->fan.dev), fan->description);
+				dev_name(&fan->adev->dev), fan->description);
 	}
 
 	/* set up RO dev_ext_attribute */
@@ -1132,114 +2263,901 @@ static acpi_status galaxybook_add_fan(acpi_handle handle, u32 level, void *conte
 
 	if (sysfs_create_file(&adev->dev.kobj, &fan->fan_speed_rpm_ext_attr.attr.attr))
 		pr_err("unable to create fan_speed_rpm attribute for fan device %s (%s)\n",
-				dev_name(&fan->fan.dev), fan->description);
+				dev_name(&fan->adev->dev), fan->description);
 
 	galaxybook->fans_count++;
 
-	return 0;
+	return 0;
+
+err_release:
+	galaxybook_fan_release(fan);
+	return 0;
+}
+
+static acpi_status galaxybook_count_fans(acpi_handle handle, u32 level, void *context,
+				void **return_value)
+{
+	(*(int *)context)++;
+	return AE_OK;
+}
+
+/*
+ * Temperatures
+ *
+ * The thermal zones' _TMP methods just convert an EC field (CTMP) to tenths of Kelvin, so the
+ * field is read directly along with the fan level fields instead.
+ */
+
+#define ACPI_THERMAL_CRITICAL  "_CRT"
+#define EC_TEMP_INVALID        0xff
+
+struct galaxybook_temp_zone {
+	const char *zone;
+	const char *field;
+};
+
+static const struct galaxybook_temp_zone galaxybook_temp_zones[] = {
+	{ "\\_TZ.TZ00", "CTMP" },
+	{ "\\_TZ.TZ01", "CTMP" },
+};
+
+static int galaxybook_temp_get(struct galaxybook_temp *temp, u64 not_before, long *value)
+{
+	unsigned long long raw;
+	int err;
+
+	err = galaxybook_field_read(temp->field, not_before, &raw);
+	if (err)
+		return err;
+
+	/* _TMP also treats this as "no reading" */
+	if (raw == EC_TEMP_INVALID)
+		return -ENODATA;
+
+	*value = raw * MILLIDEGREE_PER_DEGREE;
+	return 0;
+}
+
+static void galaxybook_temp_init(struct samsung_galaxybook *galaxybook)
+{
+	const struct galaxybook_temp_zone *zone;
+	struct galaxybook_field *field;
+	struct galaxybook_temp *temp;
+	unsigned long long crt;
+	acpi_handle handle;
+
+	for (int i = 0; i < ARRAY_SIZE(galaxybook_temp_zones); i++) {
+		zone = &galaxybook_temp_zones[i];
+		if (ACPI_FAILURE(acpi_get_handle(NULL, zone->zone, &handle)))
+			continue;
+
+		field = galaxybook_field_get(galaxybook, zone->field);
+		if (!field)
+			continue;
+
+		/* zones which read the same field are reported as one channel */
+		temp = NULL;
+		for (int j = 0; j < galaxybook->temps_count; j++) {
+			if (galaxybook->temps[j].field == field)
+				temp = &galaxybook->temps[j];
+		}
+		if (!temp) {
+			temp = &galaxybook->temps[galaxybook->temps_count++];
+			temp->field = field;
+			pr_info("found %s field for thermal zone %s\n", field->name, zone->zone);
+		}
+
+		if (!temp->has_crit && ACPI_SUCCESS(acpi_evaluate_integer(handle,
+				ACPI_THERMAL_CRITICAL, NULL, &crt))) {
+			temp->crit = deci_kelvin_to_millicelsius(crt);
+			temp->has_crit = true;
+		}
+	}
+}
+
+/* read every EC field with the same bound, so that fans and temperatures come from one pass */
+static void galaxybook_fields_refresh(struct samsung_galaxybook *galaxybook, u64 not_before)
+{
+	unsigned long long value;
+
+	for (int i = 0; i < galaxybook->fields_count; i++)
+		galaxybook_field_read(&galaxybook->fields[i], not_before, &value);
+}
+
+/*
+ * Background fan sampler
+ *
+ * When fan_sample_period_ms is set, opening one of the debugfs fan*_samples files starts a
+ * delayed work which reads every fan at that period into its ring buffer. Each open or read
+ * of a samples file keeps it going; once nobody has done either for FAN_SAMPLER_IDLE_MS the
+ * work stops rescheduling itself until the next open.
+ */
+
+static void galaxybook_fan_sampler_work(struct work_struct *work)
+{
+	struct samsung_galaxybook *galaxybook =
+		container_of(work, struct samsung_galaxybook, fan_sampler_work.work);
+	unsigned int period_ms = READ_ONCE(fan_sample_period_ms);
+	struct galaxybook_fan_sample *sample;
+	struct galaxybook_fan *fan;
+	unsigned int speed;
+	u64 pass_start;
+	u64 timestamp;
+	int level;
+
+	if (!period_ms || time_after(jiffies, READ_ONCE(galaxybook->fan_sampler_active_at) +
+			msecs_to_jiffies(FAN_SAMPLER_IDLE_MS))) {
+		if (debug_enabled())
+			pr_warn("[DEBUG] stopping fan sampler\n");
+		return;
+	}
+
+	pass_start = ktime_get_ns();
+	galaxybook_fields_refresh(galaxybook, pass_start);
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		fan = &galaxybook->fans[i];
+		if (!fan->samples)
+			continue;
+
+		/*
+		 * always read fresh values (which also refreshes the cache for other readers), but
+		 * fans sharing a level field only read it once per pass
+		 */
+		if (fan_speed_read(fan, pass_start, &speed, &level, &timestamp))
+			continue;
+
+		spin_lock(&fan->samples_lock);
+		sample = &fan->samples[fan->samples_next];
+		sample->timestamp_ns = timestamp;
+		sample->level = level;
+		sample->rpm = speed;
+		fan->samples_next = (fan->samples_next + 1) % FAN_SAMPLES_COUNT;
+		if (fan->samples_count < FAN_SAMPLES_COUNT)
+			fan->samples_count++;
+		spin_unlock(&fan->samples_lock);
+	}
+
+	schedule_delayed_work(&galaxybook->fan_sampler_work, msecs_to_jiffies(period_ms));
+}
+
+static void galaxybook_fan_sampler_touch(struct samsung_galaxybook *galaxybook)
+{
+	WRITE_ONCE(galaxybook->fan_sampler_active_at, jiffies);
+	/* no-op if the sampler is already pending */
+	if (READ_ONCE(fan_sample_period_ms))
+		schedule_delayed_work(&galaxybook->fan_sampler_work, 0);
+}
+
+/* snapshot of a fan's ring buffer, taken whenever the file is read from the start */
+struct fan_samples_snapshot {
+	struct galaxybook_fan *fan;
+	size_t len;
+	struct galaxybook_fan_sample samples[FAN_SAMPLES_COUNT];
+};
+
+static int fan_samples_open(struct inode *inode, struct file *file)
+{
+	struct fan_samples_snapshot *snapshot;
+
+	snapshot = kzalloc(sizeof(*snapshot), GFP_KERNEL);
+	if (!snapshot)
+		return -ENOMEM;
+
+	snapshot->fan = inode->i_private;
+	file->private_data = snapshot;
+
+	galaxybook_fan_sampler_touch(galaxybook_ptr);
+
+	return 0;
+}
+
+static ssize_t fan_samples_read(struct file *file, char __user *ubuf, size_t count,
+				loff_t *ppos)
+{
+	struct fan_samples_snapshot *snapshot = file->private_data;
+	struct galaxybook_fan *fan = snapshot->fan;
+	unsigned int first, n;
+
+	galaxybook_fan_sampler_touch(galaxybook_ptr);
+
+	if (*ppos == 0) {
+		spin_lock(&fan->samples_lock);
+		n = fan->samples_count;
+		first = (fan->samples_next + FAN_SAMPLES_COUNT - n) % FAN_SAMPLES_COUNT;
+		for (unsigned int i = 0; i < n; i++)
+			snapshot->samples[i] = fan->samples[(first + i) % FAN_SAMPLES_COUNT];
+		spin_unlock(&fan->samples_lock);
+		snapshot->len = n * sizeof(struct galaxybook_fan_sample);
+	}
+
+	return simple_read_from_buffer(ubuf, count, ppos, snapshot->samples, snapshot->len);
+}
+
+static int fan_samples_release(struct inode *inode, struct file *file)
+{
+	kfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations fan_samples_fops = {
+	.owner = THIS_MODULE,
+	.open = fan_samples_open,
+	.read = fan_samples_read,
+	.release = fan_samples_release,
+	.llseek = default_llseek,
+};
+
+/*
+ * one line per state with the time spent in it in ms, like cpufreq's stats/time_in_state,
+ * followed by the number of transitions; writing anything resets the statistics
+ */
+static int fan_time_in_state_show(struct seq_file *m, void *v)
+{
+	struct galaxybook_fan *fan = m->private;
+	u64 now = ktime_get_ns();
+	u64 time_ns;
+
+	mutex_lock(&fan->sample_lock);
+	for (int i = 0; i < fan->stats_count; i++) {
+		time_ns = fan->stats_time_ns[i];
+		if (i == fan->stats_state)
+			time_ns += now - fan->stats_since;
+		seq_printf(m, "%u %llu\n", fan->stats_keys[i], div_u64(time_ns, NSEC_PER_MSEC));
+	}
+	time_ns = fan->stats_time_ns[FAN_STATS_OTHER];
+	if (fan->stats_state == FAN_STATS_OTHER)
+		time_ns += now - fan->stats_since;
+	if (time_ns)
+		seq_printf(m, "other %llu\n", div_u64(time_ns, NSEC_PER_MSEC));
+	seq_printf(m, "transitions %llu\n", fan->stats_transitions);
+	mutex_unlock(&fan->sample_lock);
+
+	return 0;
+}
+
+static int fan_time_in_state_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fan_time_in_state_show, inode->i_private);
+}
+
+static ssize_t fan_time_in_state_write(struct file *file, const char __user *ubuf, size_t count,
+				loff_t *ppos)
+{
+	struct galaxybook_fan *fan = ((struct seq_file *)file->private_data)->private;
+
+	mutex_lock(&fan->sample_lock);
+	fan_stats_reset(fan, ktime_get_ns());
+	mutex_unlock(&fan->sample_lock);
+
+	return count;
+}
+
+static const struct file_operations fan_time_in_state_fops = {
+	.owner = THIS_MODULE,
+	.open = fan_time_in_state_open,
+	.read = seq_read,
+	.write = fan_time_in_state_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void galaxybook_fan_stats_init(struct samsung_galaxybook *galaxybook)
+{
+	char name[24];
+
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		snprintf(name, sizeof(name), "fan%d_time_in_state", i + 1);
+		galaxybook->fans[i].stats_file = debugfs_create_file(name, 0644, galaxybook->debugfs,
+				&galaxybook->fans[i], &fan_time_in_state_fops);
+	}
+}
+
+static void galaxybook_fan_stats_exit(struct samsung_galaxybook *galaxybook)
+{
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		debugfs_remove(galaxybook->fans[i].stats_file);
+		galaxybook->fans[i].stats_file = NULL;
+	}
+}
+
+static void galaxybook_fan_sampler_init(struct samsung_galaxybook *galaxybook)
+{
+	struct galaxybook_fan *fan;
+	char name[16];
+
+	INIT_DELAYED_WORK(&galaxybook->fan_sampler_work, galaxybook_fan_sampler_work);
+
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		fan = &galaxybook->fans[i];
+		spin_lock_init(&fan->samples_lock);
+		fan->samples_next = 0;
+		fan->samples_count = 0;
+		fan->samples = kcalloc(FAN_SAMPLES_COUNT, sizeof(*fan->samples), GFP_KERNEL);
+		if (!fan->samples)
+			continue;
+
+		snprintf(name, sizeof(name), "fan%d_samples", i + 1);
+		fan->samples_file = debugfs_create_file(name, 0444, galaxybook->debugfs, fan,
+				&fan_samples_fops);
+	}
+}
+
+static void galaxybook_fan_sampler_exit(struct samsung_galaxybook *galaxybook)
+{
+	struct galaxybook_fan *fan;
+
+	/* remove the files first so that nothing can start the sampler again */
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		debugfs_remove(galaxybook->fans[i].samples_file);
+		galaxybook->fans[i].samples_file = NULL;
+	}
+
+	cancel_delayed_work_sync(&galaxybook->fan_sampler_work);
+
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		fan = &galaxybook->fans[i];
+		kfree(fan->samples);
+		fan->samples = NULL;
+	}
+}
+
+/*
+ * Fan change notifications
+ */
+
+#if IS_ENABLED(CONFIG_HWMON)
+static struct galaxybook_fan_attr *galaxybook_fan_attr_get(struct samsung_galaxybook *galaxybook,
+				int fan, enum galaxybook_fan_attr_item item)
+{
+	return &galaxybook->hwmon_fan_attrs[fan * GB_HWMON_FAN_ATTR_COUNT + item];
+}
+#endif
+
+static void galaxybook_fan_changed(struct samsung_galaxybook *galaxybook,
+				struct galaxybook_fan *fan, u64 now)
+{
+	unsigned int speed;
+	u64 timestamp;
+	int level;
+
+	/*
+	 * take a fresh sample right away, so that the woken up reader sees the new speed and the
+	 * time in state statistics switch state at the right time
+	 */
+	fan_speed_read(fan, now, &speed, &level, &timestamp);
+
+	sysfs_notify(&fan->adev->dev.kobj, NULL, fan->fan_speed_rpm_ext_attr.attr.attr.name);
+#if IS_ENABLED(CONFIG_HWMON)
+	if (galaxybook->hwmon) {
+		hwmon_notify_event(galaxybook->hwmon, hwmon_fan, hwmon_fan_input,
+				fan - galaxybook->fans);
+		if (level >= 0)
+			sysfs_notify(&galaxybook->hwmon->kobj, NULL,
+					galaxybook_fan_attr_get(galaxybook, fan - galaxybook->fans,
+						GB_HWMON_FAN_ATTR_LEVEL)->name);
+	}
+#endif
+}
+
+static void galaxybook_fan_notify(acpi_handle handle, u32 event, void *context)
+{
+	struct galaxybook_fan *fan = context;
+	struct samsung_galaxybook *galaxybook = galaxybook_ptr;
+	struct galaxybook_field *field = fan->field;
+	u64 now = ktime_get_ns();
+
+	if (debug_enabled())
+		pr_warn("[DEBUG] fan device %s notification event: 0x%x\n",
+				dev_name(&fan->adev->dev), event);
+
+	if (event != ACPI_FAN_NOTIFY_STATUS_CHANGED)
+		return;
+
+	if (fan->supports_fst || !field) {
+		galaxybook_fan_changed(galaxybook, fan, now);
+		return;
+	}
+
+	/* the level field changed, so every fan reading it has changed as well (one field read) */
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		if (!galaxybook->fans[i].supports_fst && galaxybook->fans[i].field == field)
+			galaxybook_fan_changed(galaxybook, &galaxybook->fans[i], now);
+	}
+}
+
+/* called once the hwmon device exists, so that notifications can be passed on to it */
+static void galaxybook_fan_notify_init(struct samsung_galaxybook *galaxybook)
+{
+	struct galaxybook_fan *fan;
+	acpi_status status;
+
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		fan = &galaxybook->fans[i];
+		status = acpi_install_notify_handler(fan->adev->handle, ACPI_DEVICE_NOTIFY,
+				galaxybook_fan_notify, fan);
+		if (ACPI_FAILURE(status)) {
+			pr_warn("unable to install notify handler for fan device %s; got %s\n",
+					dev_name(&fan->adev->dev), acpi_format_exception(status));
+			continue;
+		}
+		fan->notify_installed = true;
+	}
+}
+
+/* waits for running handlers, so must be called before the hwmon device goes away */
+static void galaxybook_fan_notify_exit(struct samsung_galaxybook *galaxybook)
+{
+	struct galaxybook_fan *fan;
+
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		fan = &galaxybook->fans[i];
+		if (!fan->notify_installed)
+			continue;
+		acpi_remove_notify_handler(fan->adev->handle, ACPI_DEVICE_NOTIFY,
+				galaxybook_fan_notify);
+		fan->notify_installed = false;
+	}
+}
+
+static void galaxybook_sensors_free(struct samsung_galaxybook *galaxybook)
+{
+	for (int i = 0; i < galaxybook->fans_count; i++)
+		galaxybook_fan_release(&galaxybook->fans[i]);
+
+	for (int i = 0; i < galaxybook->fields_count; i++)
+		mutex_destroy(&galaxybook->fields[i].lock);
+
+	kfree(galaxybook->fields);
+	galaxybook->fields = NULL;
+	galaxybook->fields_allocated = 0;
+	galaxybook->fields_count = 0;
+
+	kfree(galaxybook->temps);
+	galaxybook->temps = NULL;
+	galaxybook->temps_count = 0;
+
+	kfree(galaxybook->fans);
+	galaxybook->fans = NULL;
+	galaxybook->fans_allocated = 0;
+	galaxybook->fans_count = 0;
+}
+
+/*
+ * temperatures are read from the same EC fields as the fans, so they are set up together even
+ * when fan_speed is disabled (in which case no fans are added)
+ */
+static int __init galaxybook_sensors_init(struct samsung_galaxybook *galaxybook)
+{
+	acpi_status status;
+	int count = 0;
+
+	galaxybook->fan_update_interval_ms = FAN_UPDATE_INTERVAL_DEFAULT_MS;
+
+	/* size the fan array for every fan device, even though some of them may be skipped */
+	if (fan_speed) {
+		status = acpi_get_devices(ACPI_FAN_DEVICE_ID, galaxybook_count_fans, &count, NULL);
+		if (ACPI_FAILURE(status))
+			return status;
+	}
+
+	galaxybook->fans = kcalloc(count, sizeof(*galaxybook->fans), GFP_KERNEL);
+	galaxybook->fields = kcalloc(count + ARRAY_SIZE(galaxybook_temp_zones),
+			sizeof(*galaxybook->fields), GFP_KERNEL);
+	galaxybook->temps = kcalloc(ARRAY_SIZE(galaxybook_temp_zones),
+			sizeof(*galaxybook->temps), GFP_KERNEL);
+	if (!galaxybook->fans || !galaxybook->fields || !galaxybook->temps) {
+		galaxybook_sensors_free(galaxybook);
+		return -ENOMEM;
+	}
+	galaxybook->fans_allocated = count;
+	galaxybook->fields_allocated = count + ARRAY_SIZE(galaxybook_temp_zones);
+
+	/* get and set up all fans matching ACPI_FAN_DEVICE_ID */
+	if (fan_speed) {
+		status = acpi_get_devices(ACPI_FAN_DEVICE_ID, galaxybook_add_fan, galaxybook, NULL);
+		if (ACPI_FAILURE(status)) {
+			galaxybook_sensors_free(galaxybook);
+			return status;
+		}
+	} else {
+		pr_warn("fan_speed is disabled\n");
+	}
+
+	galaxybook_temp_init(galaxybook);
+
+	galaxybook_fan_stats_init(galaxybook);
+	galaxybook_fan_sampler_init(galaxybook);
+
+	return 0;
+}
+
+static void galaxybook_sensors_exit(struct samsung_galaxybook *galaxybook)
+{
+	galaxybook_fan_sampler_exit(galaxybook);
+	galaxybook_fan_stats_exit(galaxybook);
+
+	for (int i = 0; i < galaxybook->fans_count; i++)
+		sysfs_remove_file(&galaxybook->fans[i].adev->dev.kobj,
+				&galaxybook->fans[i].fan_speed_rpm_ext_attr.attr.attr);
+
+	galaxybook_sensors_free(galaxybook);
+}
+
+
+/*
+ * Hwmon device
+ */
+
+#if IS_ENABLED(CONFIG_HWMON)
+/* slowest running and fastest speed in the level table; level 0 is the fan being off */
+static int fan_speed_range(struct galaxybook_fan *fan, unsigned int *speed_min,
+				unsigned int *speed_max)
+{
+	int ret = -ENODATA;
+
+	*speed_min = UINT_MAX;
+	*speed_max = 0;
+
+	mutex_lock(&fan->sample_lock);
+	for (int i = 0; i < fan->fan_speeds_count; i++) {
+		if (fan->fan_speeds[i])
+			*speed_min = min(*speed_min, fan->fan_speeds[i]);
+		*speed_max = max(*speed_max, fan->fan_speeds[i]);
+		ret = 0;
+	}
+	mutex_unlock(&fan->sample_lock);
+
+	if (*speed_min == UINT_MAX)
+		*speed_min = 0;
+
+	return ret;
+}
+
+static umode_t galaxybook_hwmon_is_visible(const void *drvdata, enum hwmon_sensor_types type,
+				u32 attr, int channel)
+{
+	switch (type) {
+	case hwmon_chip:
+		if (attr == hwmon_chip_update_interval)
+			return 0644;
+		return 0;
+	case hwmon_fan:
+		if (channel >= galaxybook_ptr->fans_count)
+			return 0;
+		if (attr == hwmon_fan_input || attr == hwmon_fan_label)
+			return 0444;
+		/* the range comes from the level table, which fans using _FST do not have */
+		if ((attr == hwmon_fan_min || attr == hwmon_fan_max) &&
+				!galaxybook_ptr->fans[channel].supports_fst)
+			return 0444;
+		return 0;
+	case hwmon_temp:
+		if (channel < galaxybook_ptr->temps_count &&
+				(attr == hwmon_temp_input || attr == hwmon_temp_label ||
+				 attr == hwmon_temp_crit))
+			return 0444;
+		return 0;
+	default:
+		return 0;
+	}
+}
+
+static int galaxybook_hwmon_read(struct device *dev, enum hwmon_sensor_types type,
+				u32 attr, int channel, long *val)
+{
+	struct samsung_galaxybook *galaxybook = galaxybook_ptr;
+	unsigned int speed, speed_min, speed_max;
+	u64 not_before;
+	u64 timestamp;
+	int level;
+	int err;
+
+	switch (type) {
+	case hwmon_chip:
+		if (attr == hwmon_chip_update_interval) {
+			*val = READ_ONCE(galaxybook->fan_update_interval_ms);
+			return 0;
+		}
+		return -EOPNOTSUPP;
+	case hwmon_fan:
+		if (channel < galaxybook->fans_count && attr == hwmon_fan_input) {
+			/* a stale reading refreshes all fans and temperatures at once */
+			not_before = galaxybook_sample_not_before(galaxybook);
+			galaxybook_fields_refresh(galaxybook, not_before);
+			if (fan_speed_read(&galaxybook->fans[channel], not_before, &speed, &level,
+					&timestamp))
+				return -EIO;
+			*val = speed;
+			return 0;
+		}
+		if (channel < galaxybook->fans_count &&
+				(attr == hwmon_fan_min || attr == hwmon_fan_max)) {
+			err = fan_speed_range(&galaxybook->fans[channel], &speed_min, &speed_max);
+			if (err)
+				return err;
+			*val = attr == hwmon_fan_min ? speed_min : speed_max;
+			return 0;
+		}
+		return -EOPNOTSUPP;
+	case hwmon_temp:
+		if (channel >= galaxybook->temps_count)
+			return -EOPNOTSUPP;
+		if (attr == hwmon_temp_input) {
+			not_before = galaxybook_sample_not_before(galaxybook);
+			galaxybook_fields_refresh(galaxybook, not_before);
+			err = galaxybook_temp_get(&galaxybook->temps[channel], not_before, val);
+			if (err && err != -ENODATA)
+				return -EIO;
+			return err;
+		}
+		if (attr == hwmon_temp_crit) {
+			*val = galaxybook->temps[channel].crit;
+			return 0;
+		}
+		return -EOPNOTSUPP;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int galaxybook_hwmon_write(struct device *dev, enum hwmon_sensor_types type,
+				u32 attr, int channel, long val)
+{
+	switch (type) {
+	case hwmon_chip:
+		if (attr == hwmon_chip_update_interval) {
+			/* 0 disables caching so that every read evaluates the fan again */
+			val = clamp_val(val, 0, FAN_UPDATE_INTERVAL_MAX_MS);
+			WRITE_ONCE(galaxybook_ptr->fan_update_interval_ms, val);
+			return 0;
+		}
+		return -EOPNOTSUPP;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int galaxybook_hwmon_read_string(struct device *dev, enum hwmon_sensor_types type,
+				u32 attr, int channel, const char **str)
+{
+	switch (type) {
+	case hwmon_fan:
+		if (channel < galaxybook_ptr->fans_count && attr == hwmon_fan_label) {
+			*str = galaxybook_ptr->fans[channel].description;
+			return 0;
+		}
+		return -EOPNOTSUPP;
+	case hwmon_temp:
+		if (channel < galaxybook_ptr->temps_count && attr == hwmon_temp_label) {
+			*str = galaxybook_ptr->temps[channel].field->name;
+			return 0;
+		}
+		return -EOPNOTSUPP;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static const struct hwmon_ops galaxybook_hwmon_ops = {
+	.is_visible = galaxybook_hwmon_is_visible,
+	.read = galaxybook_hwmon_read,
+	.write = galaxybook_hwmon_write,
+	.read_string = galaxybook_hwmon_read_string,
+};
+
+static const struct hwmon_channel_info * const galaxybook_hwmon_chip =
+	HWMON_CHANNEL_INFO(chip, HWMON_C_UPDATE_INTERVAL);
+
+/* speed in RPM for each level of a fan using a level field, e.g. "0 3510 3820 4430 4740 5740" */
+static ssize_t fan_levels_show(struct device *dev, struct device_attribute *attr, char *buffer)
+{
+	struct galaxybook_fan *fan = &galaxybook_ptr->fans[to_sensor_dev_attr(attr)->index];
+	int len = 0;
+
+	mutex_lock(&fan->sample_lock);
+	for (int i = 0; i < fan->fan_speeds_count; i++)
+		len += sysfs_emit_at(buffer, len, "%s%u", i ? " " : "", fan->fan_speeds[i]);
+	mutex_unlock(&fan->sample_lock);
+	len += sysfs_emit_at(buffer, len, "\n");
+
+	return len;
+}
+
+/* replaces the speeds of the first levels with the given list, separated by spaces */
+static ssize_t fan_levels_store(struct device *dev, struct device_attribute *attr,
+				const char *buffer, size_t count)
+{
+	struct galaxybook_fan *fan = &galaxybook_ptr->fans[to_sensor_dev_attr(attr)->index];
+	unsigned int speeds[FAN_LEVELS_MAX];
+	char *buf, *p, *token;
+	int n = 0;
+	int err = 0;
+
+	buf = kstrndup(buffer, count, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	p = buf;
+	while ((token = strsep(&p, " \t\n"))) {
+		if (!*token)
+			continue;
+		if (n >= FAN_LEVELS_MAX || kstrtouint(token, 0, &speeds[n])) {
+			err = -EINVAL;
+			break;
+		}
+		n++;
+	}
+	kfree(buf);
+	if (err)
+		return err;
+
+	err = fan_speed_list_set(fan, speeds, n);
+	if (err)
+		return err;
+
+	return count;
+}
+
+/* current level index of a fan using a level field, from the same sample as fan*_input */
+static ssize_t fan_level_show(struct device *dev, struct device_attribute *attr, char *buffer)
+{
+	struct galaxybook_fan *fan = &galaxybook_ptr->fans[to_sensor_dev_attr(attr)->index];
+	unsigned int speed;
+	u64 timestamp;
+	int level;
+	int err;
+
+	err = fan_speed_read(fan, galaxybook_sample_not_before(galaxybook_ptr), &speed, &level,
+			&timestamp);
+	if (err)
+		return err;
+
+	return sysfs_emit(buffer, "%d\n", level);
 }
 
-static int __init galaxybook_fan_speed_init(struct samsung_galaxybook *galaxybook)
+static umode_t galaxybook_fan_attr_is_visible(struct kobject *kobj, struct attribute *attr,
+				int n)
 {
-	/* get and set up all fans matching ACPI_FAN_DEVICE_ID */
-	return acpi_get_devices(ACPI_FAN_DEVICE_ID, galaxybook_add_fan, galaxybook, NULL);
+	struct device_attribute *dev_attr = container_of(attr, struct device_attribute, attr);
+
+	/* _FST reports a speed directly, so there are no levels to report or calibrate */
+	if (galaxybook_ptr->fans[to_sensor_dev_attr(dev_attr)->index].supports_fst)
+		return 0;
+	return attr->mode;
 }
 
-static void galaxybook_fan_speed_exit(struct samsung_galaxybook *galaxybook)
+static void galaxybook_fan_attr_init(struct galaxybook_fan_attr *fan_attr, int fan,
+				const char *suffix, umode_t mode,
+				ssize_t (*show)(struct device *, struct device_attribute *, char *),
+				ssize_t (*store)(struct device *, struct device_attribute *,
+						 const char *, size_t))
 {
-	for (int i = 0; i < galaxybook->fans_count; i++)
-		sysfs_remove_file(&galaxybook->fans[i].fan.dev.kobj,
-				&galaxybook->fans[i].fan_speed_rpm_ext_attr.attr.attr);
+	snprintf(fan_attr->name, sizeof(fan_attr->name), "fan%d_%s", fan + 1, suffix);
+	sysfs_attr_init(&fan_attr->sda.dev_attr.attr);
+	fan_attr->sda.dev_attr.attr.name = fan_attr->name;
+	fan_attr->sda.dev_attr.attr.mode = mode;
+	fan_attr->sda.dev_attr.show = show;
+	fan_attr->sda.dev_attr.store = store;
+	fan_attr->sda.index = fan;
 }
 
+static int galaxybook_hwmon_groups_init(struct samsung_galaxybook *galaxybook)
+{
+	int count = galaxybook->fans_count * GB_HWMON_FAN_ATTR_COUNT;
 
-/*
- * Hwmon device
- */
+	galaxybook->hwmon_fan_attrs = kcalloc(count, sizeof(*galaxybook->hwmon_fan_attrs),
+			GFP_KERNEL);
+	galaxybook->hwmon_fan_attr_ptrs = kcalloc(count + 1,
+			sizeof(*galaxybook->hwmon_fan_attr_ptrs), GFP_KERNEL);
+	if (!galaxybook->hwmon_fan_attrs || !galaxybook->hwmon_fan_attr_ptrs)
+		return -ENOMEM;
 
-#if IS_ENABLED(CONFIG_HWMON)
-static umode_t galaxybook_hwmon_is_visible(const void *drvdata, enum hwmon_sensor_types type,
-				u32 attr, int channel)
-{
-	switch (type) {
-	case hwmon_fan:
-		if (channel < galaxybook_ptr->fans_count &&
-				(attr == hwmon_fan_input || attr == hwmon_fan_label))
-			return 0444;
-		return 0;
-	default:
-		return 0;
+	for (int i = 0; i < galaxybook->fans_count; i++) {
+		galaxybook_fan_attr_init(galaxybook_fan_attr_get(galaxybook, i,
+				GB_HWMON_FAN_ATTR_LEVELS), i, "levels", 0644, fan_levels_show,
+				fan_levels_store);
+		galaxybook_fan_attr_init(galaxybook_fan_attr_get(galaxybook, i,
+				GB_HWMON_FAN_ATTR_LEVEL), i, "level", 0444, fan_level_show, NULL);
+		for (int j = 0; j < GB_HWMON_FAN_ATTR_COUNT; j++)
+			galaxybook->hwmon_fan_attr_ptrs[i * GB_HWMON_FAN_ATTR_COUNT + j] =
+				&galaxybook_fan_attr_get(galaxybook, i, j)->sda.dev_attr.attr;
 	}
+
+	galaxybook->hwmon_fan_group.attrs = galaxybook->hwmon_fan_attr_ptrs;
+	galaxybook->hwmon_fan_group.is_visible = galaxybook_fan_attr_is_visible;
+	galaxybook->hwmon_groups[0] = &galaxybook->hwmon_fan_group;
+	galaxybook->hwmon_groups[1] = NULL;
+
+	return 0;
 }
 
-static int galaxybook_hwmon_read(struct device *dev, enum hwmon_sensor_types type,
-				u32 attr, int channel, long *val)
+static void galaxybook_hwmon_info_free(struct samsung_galaxybook *galaxybook)
 {
-	unsigned int speed;
+	kfree(galaxybook->hwmon_fan_config);
+	galaxybook->hwmon_fan_config = NULL;
+	kfree(galaxybook->hwmon_temp_config);
+	galaxybook->hwmon_temp_config = NULL;
+	kfree(galaxybook->hwmon_fan_attrs);
+	galaxybook->hwmon_fan_attrs = NULL;
+	kfree(galaxybook->hwmon_fan_attr_ptrs);
+	galaxybook->hwmon_fan_attr_ptrs = NULL;
+}
 
-	switch (type) {
-	case hwmon_fan:
-		if (channel < galaxybook_ptr->fans_count && attr == hwmon_fan_input) {
-			if (fan_speed_get(&galaxybook_ptr->fans[channel], &speed))
-				return -EIO;
-			*val = speed;
-			return 0;
+static int galaxybook_hwmon_info_init(struct samsung_galaxybook *galaxybook)
+{
+	int n = 0;
+
+	galaxybook->hwmon_info[n++] = galaxybook_hwmon_chip;
+
+	if (galaxybook->fans_count) {
+		/* one config entry per fan plus the terminating 0 */
+		galaxybook->hwmon_fan_config = kcalloc(galaxybook->fans_count + 1,
+				sizeof(*galaxybook->hwmon_fan_config), GFP_KERNEL);
+		if (!galaxybook->hwmon_fan_config)
+			return -ENOMEM;
+		for (int i = 0; i < galaxybook->fans_count; i++) {
+			galaxybook->hwmon_fan_config[i] = HWMON_F_INPUT | HWMON_F_LABEL;
+			if (!galaxybook->fans[i].supports_fst)
+				galaxybook->hwmon_fan_config[i] |= HWMON_F_MIN | HWMON_F_MAX;
 		}
-		return -EOPNOTSUPP;
-	default:
-		return -EOPNOTSUPP;
+
+		galaxybook->hwmon_fan_info.type = hwmon_fan;
+		galaxybook->hwmon_fan_info.config = galaxybook->hwmon_fan_config;
+		galaxybook->hwmon_info[n++] = &galaxybook->hwmon_fan_info;
 	}
-}
 
-static int galaxybook_hwmon_read_string(struct device *dev, enum hwmon_sensor_types type,
-				u32 attr, int channel, const char **str)
-{
-	switch (type) {
-	case hwmon_fan:
-		if (channel < galaxybook_ptr->fans_count && attr == hwmon_fan_label) {
-			*str = galaxybook_ptr->fans[channel].description;
-			return 0;
+	if (galaxybook->temps_count) {
+		galaxybook->hwmon_temp_config = kcalloc(galaxybook->temps_count + 1,
+				sizeof(*galaxybook->hwmon_temp_config), GFP_KERNEL);
+		if (!galaxybook->hwmon_temp_config)
+			return -ENOMEM;
+		for (int i = 0; i < galaxybook->temps_count; i++) {
+			galaxybook->hwmon_temp_config[i] = HWMON_T_INPUT | HWMON_T_LABEL;
+			if (galaxybook->temps[i].has_crit)
+				galaxybook->hwmon_temp_config[i] |= HWMON_T_CRIT;
 		}
-		return -EOPNOTSUPP;
-	default:
-		return -EOPNOTSUPP;
+
+		galaxybook->hwmon_temp_info.type = hwmon_temp;
+		galaxybook->hwmon_temp_info.config = galaxybook->hwmon_temp_config;
+		galaxybook->hwmon_info[n++] = &galaxybook->hwmon_temp_info;
 	}
-}
 
-static const struct hwmon_ops galaxybook_hwmon_ops = {
-	.is_visible = galaxybook_hwmon_is_visible,
-	.read = galaxybook_hwmon_read,
-	.read_string = galaxybook_hwmon_read_string,
-};
+	galaxybook->hwmon_info[n] = NULL;
 
-static const struct hwmon_channel_info * const galaxybook_hwmon_info[] = {
-	/* note: number of max possible fan channel entries here should match MAX_FAN_COUNT */
-	HWMON_CHANNEL_INFO(fan,
-			HWMON_F_INPUT | HWMON_F_LABEL,
-			HWMON_F_INPUT | HWMON_F_LABEL,
-			HWMON_F_INPUT | HWMON_F_LABEL,
-			HWMON_F_INPUT | HWMON_F_LABEL,
-			HWMON_F_INPUT | HWMON_F_LABEL),
-	NULL
-};
+	galaxybook->hwmon_chip_info.ops = &galaxybook_hwmon_ops;
+	galaxybook->hwmon_chip_info.info = galaxybook->hwmon_info;
 
-static const struct hwmon_chip_info galaxybook_hwmon_chip_info = {
-	.ops = &galaxybook_hwmon_ops,
-	.info = galaxybook_hwmon_info,
-};
+	return 0;
+}
 
 static int galaxybook_hwmon_init(struct samsung_galaxybook *galaxybook)
 {
+	char *hwmon_device_name;
 	int ret = 0;
 
-	char *hwmon_device_name = devm_hwmon_sanitize_name(&galaxybook->platform->dev,
+	/* nothing to report, e.g. fan_speed is disabled on a model without a CTMP field */
+	if (!galaxybook->fans_count && !galaxybook->temps_count)
+		return 0;
+
+	hwmon_device_name = devm_hwmon_sanitize_name(&galaxybook->platform->dev,
 			SAMSUNG_GALAXYBOOK_CLASS);
 
-	galaxybook->hwmon = devm_hwmon_device_register_with_info(&galaxybook->platform->dev,
-			hwmon_device_name, NULL, &galaxybook_hwmon_chip_info, NULL);
+	ret = galaxybook_hwmon_info_init(galaxybook);
+	if (!ret && galaxybook->fans_count)
+		ret = galaxybook_hwmon_groups_init(galaxybook);
+	if (ret) {
+		galaxybook_hwmon_info_free(galaxybook);
+		return ret;
+	}
+
+	/* not devm, since galaxybook_hwmon_exit unregisters it before the fans are freed */
+	galaxybook->hwmon = hwmon_device_register_with_info(&galaxybook->platform->dev,
+			hwmon_device_name, NULL, &galaxybook->hwmon_chip_info,
+			galaxybook->fans_count ? galaxybook->hwmon_groups : NULL);
 	if (PTR_ERR_OR_ZERO(galaxybook->hwmon)) {
 		ret = PTR_ERR(galaxybook->hwmon);
 		galaxybook->hwmon = NULL;
+		galaxybook_hwmon_info_free(galaxybook);
 	}
 
 	return ret;
@@ -1249,6 +3167,8 @@ static void galaxybook_hwmon_exit(struct samsung_galaxybook *galaxybook)
 {
 	if (galaxybook->hwmon)
 		hwmon_device_unregister(galaxybook->hwmon);
+	galaxybook->hwmon = NULL;
+	galaxybook_hwmon_info_free(galaxybook);
 }
 #endif
 
@@ -1270,18 +3190,31 @@ static int performance_mode_acpi_set(struct samsung_galaxybook *galaxybook,
 	buf.subn = 0x03;
 	buf.iob0 = performance_mode;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_PERFORMANCE_MODE, &buf,
-			SAWB_LEN_PERFORMANCE_MODE, "setting performance_mode", &buf);
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_PERFORMANCE_MODE]);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_PERFORMANCE_MODE, &buf,
+			SAWB_LEN_PERFORMANCE_MODE, "setting performance_mode", SAWB_RET_NONE);
 	if (err)
-		return err;
+		goto out_unlock;
 
-	return 0;
+	galaxybook->performance_mode = performance_mode;
+	galaxybook_cache_update(galaxybook, GB_CACHE_PERFORMANCE_MODE);
+
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_PERFORMANCE_MODE]);
+	return err;
 }
 
 static int performance_mode_acpi_get(struct samsung_galaxybook *galaxybook, u8 *performance_mode)
 {
 	struct sawb buf = {0};
-	int err;
+	int err = 0;
+
+	mutex_lock(&galaxybook->cache_locks[GB_CACHE_PERFORMANCE_MODE]);
+
+	if (galaxybook_cache_valid(galaxybook, GB_CACHE_PERFORMANCE_MODE)) {
+		*performance_mode = galaxybook->performance_mode;
+		goto out_unlock;
+	}
 
 	buf.safn = SAFN;
 	buf.sasb = 0x91;
@@ -1289,14 +3222,18 @@ static int performance_mode_acpi_get(struct samsung_galaxybook *galaxybook, u8 *
 	buf.fncn = 0x51;
 	buf.subn = 0x02;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_PERFORMANCE_MODE, &buf,
-			SAWB_LEN_PERFORMANCE_MODE, "getting performance_mode", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_PERFORMANCE_MODE, &buf,
+			SAWB_LEN_PERFORMANCE_MODE, "getting performance_mode", SAWB_RET(iob0));
 	if (err)
-		return err;
+		goto out_unlock;
 
 	*performance_mode = buf.iob0;
+	galaxybook->performance_mode = buf.iob0;
+	galaxybook_cache_update(galaxybook, GB_CACHE_PERFORMANCE_MODE);
 
-	return 0;
+out_unlock:
+	mutex_unlock(&galaxybook->cache_locks[GB_CACHE_PERFORMANCE_MODE]);
+	return err;
 }
 
 static enum platform_profile_option profile_performance_mode(
@@ -1330,6 +3267,8 @@ static int galaxybook_platform_profile_set(struct platform_profile_handler *ppro
 	if (err)
 		return err;
 
+	trace_galaxybook_profile_change(profile, galaxybook->profile_performance_modes[profile]);
+
 	pr_info("set platform profile to '%s' (performance mode 0x%02x)\n", profile_names[profile],
 			galaxybook->profile_performance_modes[profile]);
 	return 0;
@@ -1351,7 +3290,7 @@ static int galaxybook_platform_profile_get(struct platform_profile_handler *ppro
 	if (*profile == -1)
 		return -EINVAL;
 
-	if (debug)
+	if (debug_enabled())
 		pr_warn("[DEBUG] platform profile is currently '%s' (performance mode 0x%02x)\n",
 			profile_names[*profile], performance_mode);
 
@@ -1373,8 +3312,9 @@ static int galaxybook_profile_init(struct samsung_galaxybook *galaxybook)
 	buf.fncn = 0x51;
 	buf.subn = 0x01;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_PERFORMANCE_MODE, &buf,
-			SAWB_LEN_PERFORMANCE_MODE, "get supported performance modes", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_PERFORMANCE_MODE, &buf,
+			SAWB_LEN_PERFORMANCE_MODE, "get supported performance modes",
+			SAWB_RET(iob_values));
 	if (err)
 		return err;
 
@@ -1502,7 +3442,7 @@ static int galaxybook_platform_probe(struct platform_device *pdev)
 	const struct galaxybook_device_quirks *quirks;
 	quirks = device_get_match_data(&pdev->dev);
 	if (quirks) {
-		if (debug) {
+		if (debug_enabled()) {
 			pr_warn("[DEBUG] received following device quirks:\n");
 			pr_warn("[DEBUG]   disable_kbd_backlight       = %s\n",
 					quirks->disable_kbd_backlight ? "true" : "false");
@@ -1518,6 +3458,8 @@ static int galaxybook_platform_probe(struct platform_device *pdev)
 					quirks->disable_acpi_hotkeys ? "true" : "false");
 			pr_warn("[DEBUG]   disable_wmi_hotkeys         = %s\n",
 					quirks->disable_wmi_hotkeys ? "true" : "false");
+			pr_warn("[DEBUG]   i8042_keymap                = %s\n",
+					quirks->i8042_keymap ? "custom" : "default");
 		}
 		if (quirks->disable_kbd_backlight && !kbd_backlight_was_set)
 			kbd_backlight = false;
@@ -1533,6 +3475,8 @@ static int galaxybook_platform_probe(struct platform_device *pdev)
 			acpi_hotkeys = false;
 		if (quirks->disable_wmi_hotkeys && !wmi_hotkeys_was_set)
 			wmi_hotkeys = false;
+		if (quirks->i8042_keymap)
+			i8042_keymap = quirks->i8042_keymap;
 	}
 	return 0;
 }
@@ -1577,13 +3521,11 @@ static void galaxybook_platform_exit(struct samsung_galaxybook *galaxybook)
  * Hotkey work and filters
  */
 
-static void galaxybook_performance_mode_hotkey_work(struct work_struct *work)
+static void galaxybook_performance_mode_hotkey(struct samsung_galaxybook *galaxybook)
 {
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
 	platform_profile_cycle();
 #else
-	struct samsung_galaxybook *galaxybook = container_of(work,
-			struct samsung_galaxybook, performance_mode_hotkey_work);
 	u8 current_performance_mode;
 	enum platform_profile_option current_profile;
 	int i;
@@ -1616,69 +3558,161 @@ static void galaxybook_performance_mode_hotkey_work(struct work_struct *work)
 	return;
 }
 
+static void galaxybook_kbd_backlight_hotkey(struct samsung_galaxybook *galaxybook)
+{
+	galaxybook->kbd_backlight_hotkey_presses++;
+	mod_delayed_work(galaxybook->hotkey_wq, &galaxybook->kbd_backlight_hotkey_work,
+			msecs_to_jiffies(KBD_BACKLIGHT_HOTKEY_SETTLE_MS));
+}
+
+/* apply all presses since the last settled state with a single write */
 static void galaxybook_kbd_backlight_hotkey_work(struct work_struct *work)
 {
-	struct samsung_galaxybook *galaxybook = container_of(work,
+	struct samsung_galaxybook *galaxybook = container_of(to_delayed_work(work),
 			struct samsung_galaxybook, kbd_backlight_hotkey_work);
+	unsigned int presses = galaxybook->kbd_backlight_hotkey_presses;
+	enum led_brightness brightness;
 
-	if (galaxybook->kbd_backlight.brightness < galaxybook->kbd_backlight.max_brightness)
-		kbd_backlight_acpi_set(galaxybook, galaxybook->kbd_backlight.brightness + 1);
-	else
-		kbd_backlight_acpi_set(galaxybook, 0);
+	galaxybook->kbd_backlight_hotkey_presses = 0;
+	if (!presses)
+		return;
 
-	led_classdev_notify_brightness_hw_changed(&galaxybook->kbd_backlight,
-			galaxybook->kbd_backlight.brightness);
+	if (kbd_backlight_acpi_get(galaxybook, &brightness))
+		return;
 
-	return;
+	/* each press cycles to the next level, starting again at 0 after the maximum */
+	brightness = (brightness + presses) % (galaxybook->kbd_backlight.max_brightness + 1);
+
+	if (kbd_backlight_acpi_set(galaxybook, brightness))
+		return;
+
+	led_classdev_notify_brightness_hw_changed(&galaxybook->kbd_backlight, brightness);
 }
 
-static void galaxybook_allow_recording_hotkey_work(struct work_struct *work)
+static void galaxybook_allow_recording_hotkey(struct samsung_galaxybook *galaxybook)
 {
-	struct samsung_galaxybook *galaxybook = container_of(work,
-			struct samsung_galaxybook, allow_recording_hotkey_work);
 	bool value;
 
-	allow_recording_acpi_get(galaxybook, &value);
+	/* the current value is normally served from the cache, making this a single set */
+	if (allow_recording_acpi_get(galaxybook, &value))
+		return;
+
 	allow_recording_acpi_set(galaxybook, !value);
+}
 
-	return;
+/* only this work (on an ordered workqueue) removes events, so it does not need the lock */
+static void galaxybook_hotkey_work(struct work_struct *work)
+{
+	struct samsung_galaxybook *galaxybook = container_of(work,
+			struct samsung_galaxybook, hotkey_work);
+	u8 event;
+
+	while (kfifo_get(&galaxybook->hotkey_fifo, &event)) {
+		switch (event) {
+		case GB_HOTKEY_KBD_BACKLIGHT:
+			galaxybook_kbd_backlight_hotkey(galaxybook);
+			break;
+		case GB_HOTKEY_ALLOW_RECORDING:
+			galaxybook_allow_recording_hotkey(galaxybook);
+			break;
+		case GB_HOTKEY_PERFORMANCE_MODE:
+			galaxybook_performance_mode_hotkey(galaxybook);
+			break;
+		}
+	}
+}
+
+/* can be called from interrupt context (i8042 filter) */
+static void galaxybook_hotkey_queue(struct samsung_galaxybook *galaxybook, u8 event)
+{
+	if (!kfifo_in_spinlocked(&galaxybook->hotkey_fifo, &event, 1,
+			&galaxybook->hotkey_fifo_lock))
+		pr_warn_ratelimited("hotkey event queue is full; dropping event %u\n", event);
+
+	queue_work(galaxybook->hotkey_wq, &galaxybook->hotkey_work);
+}
+
+static int galaxybook_hotkey_init(struct samsung_galaxybook *galaxybook)
+{
+	INIT_KFIFO(galaxybook->hotkey_fifo);
+	spin_lock_init(&galaxybook->hotkey_fifo_lock);
+	INIT_WORK(&galaxybook->hotkey_work, galaxybook_hotkey_work);
+	INIT_DELAYED_WORK(&galaxybook->kbd_backlight_hotkey_work,
+			galaxybook_kbd_backlight_hotkey_work);
+
+	galaxybook->hotkey_wq = alloc_ordered_workqueue("%s-hotkeys", WQ_HIGHPRI,
+			SAMSUNG_GALAXYBOOK_CLASS);
+	if (!galaxybook->hotkey_wq)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void galaxybook_hotkey_exit(struct samsung_galaxybook *galaxybook)
+{
+	/*
+	 * let queued kbd_backlight presses arm the settle timer and apply them right away; the
+	 * timer must not fire while the workqueue is being drained, as it would queue from outside
+	 */
+	flush_work(&galaxybook->hotkey_work);
+	flush_delayed_work(&galaxybook->kbd_backlight_hotkey_work);
+	/* any other events still queued are handled before the workqueue is destroyed */
+	drain_workqueue(galaxybook->hotkey_wq);
+	destroy_workqueue(galaxybook->hotkey_wq);
+	galaxybook->hotkey_wq = NULL;
+}
+
+static const char * const galaxybook_i8042_action_names[] = {
+	[GB_I8042_NONE] = "none",
+	[GB_I8042_KBD_BACKLIGHT_KEYDOWN] = "kbd_backlight keydown",
+	[GB_I8042_KBD_BACKLIGHT_KEYUP] = "kbd_backlight keyup",
+	[GB_I8042_ALLOW_RECORDING_KEYDOWN] = "allow_recording keydown",
+	[GB_I8042_ALLOW_RECORDING_KEYUP] = "allow_recording keyup",
+};
+static_assert(ARRAY_SIZE(galaxybook_i8042_action_names) == GB_I8042_ACTION_COUNT);
+
+static void galaxybook_i8042_action(u8 action, unsigned char data)
+{
+	if (debug_enabled())
+		pr_warn("[DEBUG] hotkey: %s\n", galaxybook_i8042_action_names[action]);
+
+	switch (action) {
+	case GB_I8042_KBD_BACKLIGHT_KEYUP:
+		trace_galaxybook_hotkey(GALAXYBOOK_HOTKEY_SOURCE_I8042, data);
+		if (kbd_backlight)
+			galaxybook_hotkey_queue(galaxybook_ptr, GB_HOTKEY_KBD_BACKLIGHT);
+		break;
+	case GB_I8042_ALLOW_RECORDING_KEYUP:
+		trace_galaxybook_hotkey(GALAXYBOOK_HOTKEY_SOURCE_I8042, data);
+		galaxybook_hotkey_queue(galaxybook_ptr, GB_HOTKEY_ALLOW_RECORDING);
+		break;
+	default:
+		/* keydown events are only logged; the action happens on keyup */
+		break;
+	}
 }
 
 static bool galaxybook_i8042_filter(unsigned char data, unsigned char str,
 				    				struct serio *port)
 {
 	static bool extended;
+	u8 action;
 
 	if (data == 0xe0) {
 		extended = true;
-	} else if (likely(extended)) {
-		extended = false;
+		return false;
+	}
+	if (likely(!extended))
+		return false;
 
-		/* kbd_backlight keydown */
-		if (data == 0x2c) {
-			if (debug)
-				pr_warn("[DEBUG] hotkey: kbd_backlight keydown\n");
-		}
-		/* kbd_backlight keyup */
-		if (data == 0xac) {
-			if (debug)
-				pr_warn("[DEBUG] hotkey: kbd_backlight keyup\n");
-			if (kbd_backlight)
-				schedule_work(&galaxybook_ptr->kbd_backlight_hotkey_work);
-		}
+	extended = false;
 
-		/* allow_recording keydown */
-		if (data == 0x1f) {
-			if (debug)
-				pr_warn("[DEBUG] hotkey: allow_recording keydown\n");
-		}
-		/* allow_recording keyup */
-		if (data == 0x9f) {
-			if (debug)
-				pr_warn("[DEBUG] hotkey: allow_recording keyup\n");
-			schedule_work(&galaxybook_ptr->allow_recording_hotkey_work);
-		}
-	}
+	/* one table lookup regardless of how many hotkeys are handled */
+	action = i8042_keymap[data];
+	if (likely(action == GB_I8042_NONE))
+		return false;
+
+	galaxybook_i8042_action(action, data);
 
 	return false;
 }
@@ -1690,18 +3724,109 @@ static bool galaxybook_i8042_filter(unsigned char data, unsigned char str,
 
 static void galaxybook_input_notify(struct samsung_galaxybook *galaxybook, int event)
 {
+	mutex_lock(&galaxybook->input_lock);
 	if (!galaxybook->input)
-		return;
-	if (debug)
+		goto out_unlock;
+	if (debug_enabled())
 		pr_warn("[DEBUG] input notification event: 0x%x\n", event);
 	if (!sparse_keymap_report_event(galaxybook->input, event, 1, true)) {
 		pr_warn("unknown input notification event: 0x%x\n", event);
 		pr_warn_create_issue();
 	}
+out_unlock:
+	mutex_unlock(&galaxybook->input_lock);
+}
+
+/*
+ * Convertibles also have an Intel HID event device which reports the current "virtual GPIO
+ * button" state, with bit 6 cleared while the device is in tablet mode. As in intel-hid, this is
+ * read through the device's _DSM (which on e.g. the NP950QDB calls VGBS under the EC) and only
+ * falls back to a VGBS method on the device itself.
+ */
+#define ACPI_INTEL_HID_VGBS       "VGBS"
+#define INTEL_HID_DSM_REVISION    1
+#define INTEL_HID_DSM_VGBS_FN     8
+#define VGBS_TABLET_MODE_FLAG     BIT(6)
+
+/* guid eeec56b3-4442-408f-a792-4edd4d758054 */
+static const guid_t intel_hid_dsm_guid =
+	GUID_INIT(0xeeec56b3, 0x4442, 0x408f, 0xa7, 0x92, 0x4e, 0xdd, 0x4d, 0x75, 0x80, 0x54);
+
+static const char * const galaxybook_intel_hid_ids[] = {
+	"INT33D5",
+	"INTC1051",
+	"INTC1054",
+	"INTC1070",
+	"INTC1076",
+	"INTC1077",
+	"INTC1078",
+	NULL,
+};
+
+/* only convertibles and detachables have a tablet mode to report, as intel-hid assumes too */
+static bool galaxybook_has_tablet_mode(void)
+{
+	const char *chassis_type = dmi_get_system_info(DMI_CHASSIS_TYPE);
+
+	return chassis_type && (!strcmp(chassis_type, "31") ||	/* Convertible */
+				!strcmp(chassis_type, "32"));	/* Detachable */
+}
+
+static acpi_status galaxybook_find_intel_hid(acpi_handle handle, u32 level, void *context,
+				void **return_value)
+{
+	*return_value = handle;
+	return AE_CTRL_TERMINATE;
+}
+
+static int galaxybook_tablet_mode_get(bool *tablet_mode)
+{
+	const char * const *hid;
+	acpi_handle hidd = NULL;
+	union acpi_object *obj;
+	unsigned long long vgbs;
+	acpi_status status;
+
+	if (!galaxybook_has_tablet_mode())
+		return -ENODEV;
+
+	for (hid = galaxybook_intel_hid_ids; *hid && !hidd; hid++)
+		acpi_get_devices(*hid, galaxybook_find_intel_hid, NULL, &hidd);
+	if (!hidd)
+		return -ENODEV;
+
+	if (acpi_check_dsm(hidd, &intel_hid_dsm_guid, INTEL_HID_DSM_REVISION,
+			BIT(INTEL_HID_DSM_VGBS_FN))) {
+		obj = acpi_evaluate_dsm_typed(hidd, &intel_hid_dsm_guid, INTEL_HID_DSM_REVISION,
+				INTEL_HID_DSM_VGBS_FN, NULL, ACPI_TYPE_INTEGER);
+		if (!obj) {
+			pr_warn("failed to read tablet mode state from _DSM function %d\n",
+					INTEL_HID_DSM_VGBS_FN);
+			return -EIO;
+		}
+		vgbs = obj->integer.value;
+		ACPI_FREE(obj);
+	} else if (acpi_has_method(hidd, ACPI_INTEL_HID_VGBS)) {
+		status = acpi_evaluate_integer(hidd, ACPI_INTEL_HID_VGBS, NULL, &vgbs);
+		if (ACPI_FAILURE(status)) {
+			pr_warn("failed to read tablet mode state from %s; got %s\n",
+					ACPI_INTEL_HID_VGBS, acpi_format_exception(status));
+			return -EIO;
+		}
+	} else {
+		return -ENODEV;
+	}
+
+	if (debug_enabled())
+		pr_warn("[DEBUG] virtual GPIO button state is 0x%llx\n", vgbs);
+
+	*tablet_mode = !(vgbs & VGBS_TABLET_MODE_FLAG);
+	return 0;
 }
 
 static int galaxybook_input_init(struct samsung_galaxybook *galaxybook)
 {
+	bool tablet_mode;
 	struct input_dev *input;
 	int error;
 
@@ -1719,13 +3844,28 @@ static int galaxybook_input_init(struct samsung_galaxybook *galaxybook)
 		pr_err("Unable to setup input device keymap\n");
 		goto err_free_dev;
 	}
+
+	/* allow_recording state as switches, starting from the value read at probe */
+	input_set_capability(input, EV_SW, SW_CAMERA_LENS_COVER);
+	input_set_capability(input, EV_SW, SW_MUTE_DEVICE);
+	if (galaxybook_cache_valid(galaxybook, GB_CACHE_ALLOW_RECORDING)) {
+		__assign_bit(SW_CAMERA_LENS_COVER, input->sw, !galaxybook->allow_recording);
+		__assign_bit(SW_MUTE_DEVICE, input->sw, !galaxybook->allow_recording);
+	}
+
+	/* tablet mode is otherwise only known after the first 0x6c/0x6d notification */
+	if (!galaxybook_tablet_mode_get(&tablet_mode))
+		__assign_bit(SW_TABLET_MODE, input->sw, tablet_mode);
+
 	error = input_register_device(input);
 	if (error) {
 		pr_warn("Unable to register input device\n");
 		goto err_free_dev;
 	}
 
+	mutex_lock(&galaxybook->input_lock);
 	galaxybook->input = input;
+	mutex_unlock(&galaxybook->input_lock);
 	return 0;
 
 err_free_dev:
@@ -1733,11 +3873,14 @@ err_free_dev:
 	return error;
 }
 
+/* hotkey work and the allow_recording attribute may still be reporting until they are gone */
 static void galaxybook_input_exit(struct samsung_galaxybook *galaxybook)
 {
+	mutex_lock(&galaxybook->input_lock);
 	if (galaxybook->input)
 		input_unregister_device(galaxybook->input);
 	galaxybook->input = NULL;
+	mutex_unlock(&galaxybook->input_lock);
 }
 
 
@@ -1800,14 +3943,35 @@ static void galaxybook_acpi_notify(struct acpi_device *device, u32 event)
 {
 	struct samsung_galaxybook *galaxybook = acpi_driver_data(device);
 
+	trace_galaxybook_hotkey(GALAXYBOOK_HOTKEY_SOURCE_ACPI, event);
+
+	/* drop any cached settings which the firmware could have changed along with this event */
+	switch (event) {
+	case ACPI_NOTIFY_BATTERY_STATE_CHANGED:
+		galaxybook_cache_invalidate(galaxybook, BIT(GB_CACHE_CHARGE_CONTROL_END_THRESHOLD));
+		break;
+	case ACPI_NOTIFY_HOTKEY_PERFORMANCE_MODE:
+		galaxybook_cache_invalidate(galaxybook, BIT(GB_CACHE_PERFORMANCE_MODE));
+		break;
+	case ACPI_NOTIFY_DEVICE_ON_TABLE:
+	case ACPI_NOTIFY_DEVICE_OFF_TABLE:
+		break;
+	default:
+		galaxybook_cache_invalidate(galaxybook, GB_CACHE_ALL);
+		break;
+	}
+
+	if (event == ACPI_NOTIFY_BATTERY_STATE_CHANGED)
+		galaxybook_battery_notify(galaxybook);
+
 	if (!acpi_hotkeys)
 		return;
 
 	if (event == ACPI_NOTIFY_HOTKEY_PERFORMANCE_MODE) {
-		if (debug)
+		if (debug_enabled())
 			pr_warn("[DEBUG] hotkey: performance_mode keydown\n");
 		if (performance_mode)
-			schedule_work(&galaxybook_ptr->performance_mode_hotkey_work);
+			galaxybook_hotkey_queue(galaxybook, GB_HOTKEY_PERFORMANCE_MODE);
 	}
 
 	galaxybook_input_notify(galaxybook, event);
@@ -1827,19 +3991,82 @@ static int galaxybook_enable_acpi_notify(struct samsung_galaxybook *galaxybook)
 	buf.gunm = 0x80;
 	buf.guds[0] = 0x02;
 
-	err = galaxybook_acpi_method(galaxybook, ACPI_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
-			"activate ACPI notifications", &buf);
+	err = galaxybook_acpi_method(galaxybook, GB_METHOD_SETTINGS, &buf, SAWB_LEN_SETTINGS,
+			"activate ACPI notifications", SAWB_RET_NONE);
 	if (err)
 		return err;
 
 	return 0;
 }
 
+/* read all settings once so that later reads can be served from the cache */
+static void galaxybook_cache_init(struct samsung_galaxybook *galaxybook)
+{
+	enum led_brightness brightness;
+	bool value;
+	u8 threshold, mode;
+
+	if (kbd_backlight)
+		kbd_backlight_acpi_get(galaxybook, &brightness);
+	if (battery_threshold)
+		charge_control_end_threshold_acpi_get(galaxybook, &threshold);
+	if (performance_mode)
+		performance_mode_acpi_get(galaxybook, &mode);
+	start_on_lid_open_acpi_get(galaxybook, &value);
+	usb_charge_acpi_get(galaxybook, &value);
+	allow_recording_acpi_get(galaxybook, &value);
+}
+
+static ssize_t resync_write(struct file *file, const char __user *ubuf, size_t count,
+				loff_t *ppos)
+{
+	struct samsung_galaxybook *galaxybook = file->private_data;
+
+	galaxybook_cache_invalidate(galaxybook, GB_CACHE_ALL);
+	galaxybook_cache_init(galaxybook);
+
+	return count;
+}
+
+static const struct file_operations resync_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.write = resync_write,
+	.llseek = noop_llseek,
+};
+
+static void galaxybook_debugfs_init(struct samsung_galaxybook *galaxybook)
+{
+	galaxybook->debugfs = debugfs_create_dir(SAMSUNG_GALAXYBOOK_CLASS, NULL);
+	debugfs_create_file("resync", 0200, galaxybook->debugfs, galaxybook, &resync_fops);
+	debugfs_create_file("sawb_lock_stats", 0444, galaxybook->debugfs, galaxybook,
+			&sawb_lock_stats_fops);
+	debugfs_create_file("sawb_latency", 0644, galaxybook->debugfs, galaxybook,
+			&sawb_latency_fops);
+}
+
+static void galaxybook_debugfs_exit(struct samsung_galaxybook *galaxybook)
+{
+	debugfs_remove_recursive(galaxybook->debugfs);
+	galaxybook->debugfs = NULL;
+}
+
 static int galaxybook_acpi_init(struct samsung_galaxybook *galaxybook)
 {
 	int err;
 
-	err = acpi_execute_simple_method(galaxybook->acpi->handle, ACPI_METHOD_ENABLE, 1);
+	/* resolve all method handles once so they can be evaluated directly later */
+	for (int i = 0; i < GB_METHOD_COUNT; i++) {
+		if (ACPI_FAILURE(acpi_get_handle(galaxybook->acpi->handle, galaxybook_method_names[i],
+				&galaxybook->methods[i]))) {
+			pr_warn("ACPI method %s was not found\n", galaxybook_method_names[i]);
+			galaxybook->methods[i] = NULL;
+		}
+	}
+	if (!galaxybook->methods[GB_METHOD_ENABLE] || !galaxybook->methods[GB_METHOD_SETTINGS])
+		return -ENODEV;
+
+	err = acpi_execute_simple_method(galaxybook->methods[GB_METHOD_ENABLE], NULL, 1);
 	if (err)
 		return err;
 
@@ -1848,7 +4075,7 @@ static int galaxybook_acpi_init(struct samsung_galaxybook *galaxybook)
 
 static void galaxybook_acpi_exit(struct samsung_galaxybook *galaxybook)
 {
-	acpi_execute_simple_method(galaxybook->acpi->handle, ACPI_METHOD_ENABLE, 0);
+	acpi_execute_simple_method(galaxybook->methods[GB_METHOD_ENABLE], NULL, 0);
 	return;
 }
 
@@ -1869,6 +4096,11 @@ static int galaxybook_acpi_add(struct acpi_device *device)
 	strcpy(acpi_device_class(device), SAMSUNG_GALAXYBOOK_CLASS);
 	device->driver_data = galaxybook;
 	galaxybook->acpi = device;
+	mutex_init(&galaxybook->sawb_lock);
+	mutex_init(&galaxybook->batteries_lock);
+	mutex_init(&galaxybook->input_lock);
+	for (int i = 0; i < GB_CACHE_COUNT; i++)
+		mutex_init(&galaxybook->cache_locks[i]);
 
 	pr_info("initializing ACPI device\n");
 	err = galaxybook_acpi_init(galaxybook);
@@ -1877,6 +4109,8 @@ static int galaxybook_acpi_add(struct acpi_device *device)
 		goto err_free;
 	}
 
+	galaxybook_debugfs_init(galaxybook);
+
 	pr_info("initializing ACPI power management features\n");
 	err = galaxybook_enable_acpi_feature(galaxybook, SASB_POWER_MANAGEMENT);
 	if (err) {
@@ -1927,66 +4161,60 @@ static int galaxybook_acpi_add(struct acpi_device *device)
 		goto err_battery_threshold_exit;
 	}
 
-	if (i8042_filter) {
-		pr_info("installing i8402 key filter to capture hotkey input\n");
+	pr_info("reading initial values of device settings\n");
+	galaxybook_cache_init(galaxybook);
 
-		/* initialize hotkey work queues */
-		INIT_WORK(&galaxybook->kbd_backlight_hotkey_work,
-				galaxybook_kbd_backlight_hotkey_work);
-		INIT_WORK(&galaxybook->allow_recording_hotkey_work,
-				galaxybook_allow_recording_hotkey_work);
+	pr_info("initializing hotkey event queue\n");
+	err = galaxybook_hotkey_init(galaxybook);
+	if (err) {
+		pr_err("failure initializing hotkey event queue\n");
+		goto err_battery_threshold_exit;
+	}
 
+	if (i8042_filter) {
+		pr_info("installing i8402 key filter to capture hotkey input\n");
 		err = i8042_install_filter(galaxybook_i8042_filter);
 		if (err) {
 			pr_err("failure installing i8402 key filter\n");
-			cancel_work_sync(&galaxybook->kbd_backlight_hotkey_work);
-			cancel_work_sync(&galaxybook->allow_recording_hotkey_work);
-			goto err_battery_threshold_exit;
+			goto err_hotkey_exit;
 		}
 	} else {
 		pr_warn("i8042_filter is disabled\n");
 	}
 
-	if (fan_speed) {
-		pr_info("initializing fan speed\n");
-		err = galaxybook_fan_speed_init(galaxybook);
-		if (err) {
-			pr_err("failure initializing fan speed\n");
-			goto err_i8042_filter_exit;
-		}
+	pr_info("initializing fan speed and temperatures\n");
+	err = galaxybook_sensors_init(galaxybook);
+	if (err) {
+		pr_err("failure initializing fan speed and temperatures\n");
+		goto err_i8042_filter_exit;
+	}
 
 #if IS_ENABLED(CONFIG_HWMON)
-		pr_info("initializing hwmon device\n");
-		err = galaxybook_hwmon_init(galaxybook);
-		if (err) {
-			pr_err("failure initializing hwmon device\n");
-			galaxybook_fan_speed_exit(galaxybook);
-			goto err_i8042_filter_exit;
-		}
-#endif
-	} else {
-		pr_warn("fan_speed is disabled\n");
+	pr_info("initializing hwmon device\n");
+	err = galaxybook_hwmon_init(galaxybook);
+	if (err) {
+		pr_err("failure initializing hwmon device\n");
+		galaxybook_sensors_exit(galaxybook);
+		goto err_i8042_filter_exit;
 	}
+#endif
+
+	galaxybook_fan_notify_init(galaxybook);
 
 	if (acpi_hotkeys) {
 		pr_info("enabling ACPI notifications\n");
 		err = galaxybook_enable_acpi_notify(galaxybook);
 		if (err) {
 			pr_err("failure enabling ACPI notifications\n");
-			goto err_fan_speed_exit;
+			goto err_sensors_exit;
 		}
 
-		/* initialize hotkey work queues */
-		INIT_WORK(&galaxybook->performance_mode_hotkey_work,
-				galaxybook_performance_mode_hotkey_work);
-
 		pr_info("initializing hotkey input device\n");
 		err = galaxybook_input_init(galaxybook);
 		if (err) {
 			pr_err("failure initializing hotkey input device\n");
-			cancel_work_sync(&galaxybook->performance_mode_hotkey_work);
 			galaxybook_input_exit(galaxybook);
-			goto err_fan_speed_exit;
+			goto err_sensors_exit;
 		}
 	} else {
 		pr_warn("acpi_hotkeys is disabled\n");
@@ -2006,23 +4234,19 @@ static int galaxybook_acpi_add(struct acpi_device *device)
 	return 0;
 
 err_acpi_hotkeys_exit:
-	if (acpi_hotkeys) {
+	if (acpi_hotkeys)
 		galaxybook_input_exit(galaxybook);
-		cancel_work_sync(&galaxybook->performance_mode_hotkey_work);
-	}
-err_fan_speed_exit:
-	if (fan_speed) {
-		galaxybook_fan_speed_exit(galaxybook);
+err_sensors_exit:
+	galaxybook_fan_notify_exit(galaxybook);
 #if IS_ENABLED(CONFIG_HWMON)
-		galaxybook_hwmon_exit(galaxybook);
+	galaxybook_hwmon_exit(galaxybook);
 #endif
-	}
+	galaxybook_sensors_exit(galaxybook);
 err_i8042_filter_exit:
-	if (i8042_filter) {
+	if (i8042_filter)
 		i8042_remove_filter(galaxybook_i8042_filter);
-		cancel_work_sync(&galaxybook->kbd_backlight_hotkey_work);
-		cancel_work_sync(&galaxybook->allow_recording_hotkey_work);
-	}
+err_hotkey_exit:
+	galaxybook_hotkey_exit(galaxybook);
 err_battery_threshold_exit:
 	if (battery_threshold)
 		battery_hook_unregister(&galaxybook_battery_hook);
@@ -2035,8 +4259,14 @@ err_performance_mode_exit:
 err_platform_exit:
 	galaxybook_platform_exit(galaxybook);
 err_acpi_exit:
+	galaxybook_debugfs_exit(galaxybook);
 	galaxybook_acpi_exit(galaxybook);
 err_free:
+	for (int i = 0; i < GB_CACHE_COUNT; i++)
+		mutex_destroy(&galaxybook->cache_locks[i]);
+	mutex_destroy(&galaxybook->input_lock);
+	mutex_destroy(&galaxybook->batteries_lock);
+	mutex_destroy(&galaxybook->sawb_lock);
 	kfree(galaxybook);
 	return err;
 }
@@ -2048,23 +4278,19 @@ static void galaxybook_acpi_remove(struct acpi_device *device)
 	if (wmi_hotkeys)
 		galaxybook_wmi_exit();
 
-	if (acpi_hotkeys) {
+	if (acpi_hotkeys)
 		galaxybook_input_exit(galaxybook);
-		cancel_work_sync(&galaxybook->performance_mode_hotkey_work);
-	}
 
-	if (fan_speed) {
-		galaxybook_fan_speed_exit(galaxybook);
+	galaxybook_fan_notify_exit(galaxybook);
 #if IS_ENABLED(CONFIG_HWMON)
-		galaxybook_hwmon_exit(galaxybook);
+	galaxybook_hwmon_exit(galaxybook);
 #endif
-	}
+	galaxybook_sensors_exit(galaxybook);
 
-	if (i8042_filter) {
+	if (i8042_filter)
 		i8042_remove_filter(galaxybook_i8042_filter);
-		cancel_work_sync(&galaxybook->kbd_backlight_hotkey_work);
-		cancel_work_sync(&galaxybook->allow_recording_hotkey_work);
-	}
+
+	galaxybook_hotkey_exit(galaxybook);
 
 	if (battery_threshold)
 		battery_hook_unregister(&galaxybook_battery_hook);
@@ -2077,14 +4303,33 @@ static void galaxybook_acpi_remove(struct acpi_device *device)
 
 	galaxybook_platform_exit(galaxybook);
 
+	galaxybook_debugfs_exit(galaxybook);
+
 	galaxybook_acpi_exit(galaxybook);
 
 	if (galaxybook_ptr)
 		galaxybook_ptr = NULL;
 
+	for (int i = 0; i < GB_CACHE_COUNT; i++)
+		mutex_destroy(&galaxybook->cache_locks[i]);
+	mutex_destroy(&galaxybook->input_lock);
+	mutex_destroy(&galaxybook->batteries_lock);
+	mutex_destroy(&galaxybook->sawb_lock);
 	kfree(galaxybook);
 }
 
+static int galaxybook_acpi_resume(struct device *dev)
+{
+	struct samsung_galaxybook *galaxybook = acpi_driver_data(to_acpi_device(dev));
+
+	/* firmware may have changed any setting while the device was asleep */
+	galaxybook_cache_invalidate(galaxybook, GB_CACHE_ALL);
+
+	return 0;
+}
+
+static DEFINE_SIMPLE_DEV_PM_OPS(galaxybook_acpi_pm_ops, NULL, galaxybook_acpi_resume);
+
 static struct acpi_driver galaxybook_acpi_driver = {
 	.name = SAMSUNG_GALAXYBOOK_NAME,
 	.class = SAMSUNG_GALAXYBOOK_CLASS,
@@ -2095,6 +4340,7 @@ static struct acpi_driver galaxybook_acpi_driver = {
 		.remove = galaxybook_acpi_remove,
 		.notify = galaxybook_acpi_notify,
 		},
+	.drv.pm = pm_sleep_ptr(&galaxybook_acpi_pm_ops),
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(6, 10, 0)
 	.owner = THIS_MODULE,
@@ -2107,6 +4353,8 @@ static int __init samsung_galaxybook_init(void)
 
 	pr_info("loading driver\n");
 
+	debug_key_update();
+
 	ret = platform_driver_register(&galaxybook_platform_driver);
 	if (ret < 0)
 		goto err_unregister_platform;